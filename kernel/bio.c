@@ -1,6 +1,6 @@
 // Buffer cache.
 //
-// The buffer cache is a linked list of buf structures holding
+// The buffer cache is a hash table of buf structures holding
 // cached copies of disk block contents.  Caching disk blocks
 // in memory reduces the number of disk reads and also provides
 // a synchronization point for disk blocks used by multiple processes.
@@ -23,69 +23,159 @@
 #include "fs.h"
 #include "buf.h"
 
+#define NBUCKET 13   // prime, so consecutive blocks spread out
+#define BHASH(dev, blockno) ((((uint64)(dev) << 27) | (blockno)) % NBUCKET)
+
 struct {
+  // serializes eviction, so at most one CPU at a time
+  // moves a buffer between buckets.
   struct spinlock lock;
   struct buf buf[NBUF];
 
-  // Linked list of all buffers, through prev/next.
-  // Sorted by how recently the buffer was used.
-  // head.next is most recent, head.prev is least.
-  struct buf head;
+  // Hash table of buffers keyed by (dev, blockno).
+  // Each bucket is a singly-linked list through next,
+  // protected by its own lock, so lookups of blocks in
+  // different buckets never share a lock.
+  struct spinlock bucketlock[NBUCKET];
+  struct buf *bucket[NBUCKET];
 } bcache;
 
 void
 binit(void)
 {
   struct buf *b;
+  int i;
 
   initlock(&bcache.lock, "bcache");
+  for(i = 0; i < NBUCKET; i++){
+    initlock(&bcache.bucketlock[i], "bcache.bucket");
+    bcache.bucket[i] = 0;
+  }
 
-  // Create linked list of buffers
-  bcache.head.prev = &bcache.head;
-  bcache.head.next = &bcache.head;
-  for(b = bcache.buf; b < bcache.buf+NBUF; b++){
-    b->next = bcache.head.next;
-    b->prev = &bcache.head;
+  // Spread the (empty) buffers over the buckets.
+  for(i = 0; i < NBUF; i++){
+    b = &bcache.buf[i];
     initsleeplock(&b->lock, "buffer");
-    bcache.head.next->prev = b;
-    bcache.head.next = b;
+    b->next = bcache.bucket[i % NBUCKET];
+    bcache.bucket[i % NBUCKET] = b;
   }
 }
 
+// Look for block (dev, blockno) in bucket h.
+// Caller must hold bcache.bucketlock[h].
+static struct buf*
+bfind(int h, uint dev, uint blockno)
+{
+  struct buf *b;
+
+  for(b = bcache.bucket[h]; b; b = b->next)
+    if(b->dev == dev && b->blockno == blockno)
+      return b;
+  return 0;
+}
+
 // Look through buffer cache for block on device dev.
 // If not found, allocate a buffer.
 // In either case, return locked buffer.
+// For read-ahead (ahead != 0), return 0 instead if the
+// block is already cached or no buffer is free.
 static struct buf*
-bget(uint dev, uint blockno)
+bget1(uint dev, uint blockno, int ahead)
 {
-  struct buf *b;
+  struct buf *b, *victim, **pp;
+  int h, i, vh;
 
-  acquire(&bcache.lock);
+  h = BHASH(dev, blockno);
 
   // Is the block already cached?
-  for(b = bcache.head.next; b != &bcache.head; b = b->next){
-    if(b->dev == dev && b->blockno == blockno){
-      b->refcnt++;
+  acquire(&bcache.bucketlock[h]);
+  if((b = bfind(h, dev, blockno)) != 0){
+    if(ahead){
+      release(&bcache.bucketlock[h]);
+      return 0;
+    }
+    b->refcnt++;
+    release(&bcache.bucketlock[h]);
+    acquiresleep(&b->lock);
+    return b;
+  }
+  release(&bcache.bucketlock[h]);
+
+  // Not cached. Only one CPU evicts at a time, and only
+  // an evicting CPU inserts into a bucket, so after taking
+  // bcache.lock a second lookup settles whether another
+  // CPU cached the block in the meantime.
+  acquire(&bcache.lock);
+  acquire(&bcache.bucketlock[h]);
+  if((b = bfind(h, dev, blockno)) != 0){
+    if(ahead){
+      release(&bcache.bucketlock[h]);
       release(&bcache.lock);
-      acquiresleep(&b->lock);
-      return b;
+      return 0;
     }
+    b->refcnt++;
+    release(&bcache.bucketlock[h]);
+    release(&bcache.lock);
+    acquiresleep(&b->lock);
+    return b;
   }
+  release(&bcache.bucketlock[h]);
 
-  // Not cached.
   // Recycle the least recently used (LRU) unused buffer.
-  for(b = bcache.head.prev; b != &bcache.head; b = b->prev){
-    if(b->refcnt == 0) {
-      b->dev = dev;
-      b->blockno = blockno;
-      b->valid = 0;
-      b->refcnt = 1;
+  // Keep the lock of the bucket holding the best candidate
+  // so it can't be picked up while we scan the rest.
+  victim = 0;
+  vh = -1;
+  for(i = 0; i < NBUCKET; i++){
+    int found = 0;
+    acquire(&bcache.bucketlock[i]);
+    for(b = bcache.bucket[i]; b; b = b->next){
+      if(b->refcnt == 0 && (victim == 0 || b->timestamp < victim->timestamp)){
+        victim = b;
+        found = 1;
+      }
+    }
+    if(found){
+      if(vh >= 0)
+        release(&bcache.bucketlock[vh]);
+      vh = i;
+    } else {
+      release(&bcache.bucketlock[i]);
+    }
+  }
+  if(victim == 0){
+    if(ahead){
       release(&bcache.lock);
-      acquiresleep(&b->lock);
-      return b;
+      return 0;
     }
+    panic("bget: no buffers");
   }
-  panic("bget: no buffers");
+
+  // Unlink the victim from its old bucket...
+  for(pp = &bcache.bucket[vh]; *pp != victim; pp = &(*pp)->next)
+    ;
+  *pp = victim->next;
+  victim->dev = dev;
+  victim->blockno = blockno;
+  victim->valid = 0;
+  victim->refcnt = 1;
+  release(&bcache.bucketlock[vh]);
+
+  // ...and put it in the new one.
+  acquire(&bcache.bucketlock[h]);
+  victim->next = bcache.bucket[h];
+  bcache.bucket[h] = victim;
+  release(&bcache.bucketlock[h]);
+  release(&bcache.lock);
+
+  acquiresleep(&victim->lock);
+  return victim;
+}
+
+static struct buf*
+bget(uint dev, uint blockno)
+{
+  return bget1(dev, blockno, 0);
 }
 
 // Return a locked buf with the contents of the indicated block.
@@ -111,8 +201,55 @@ bwrite(struct buf *b)
   virtio_disk_rw(b, 1);
 }
 
+// Write n locked bufs to disk as one batch of
+// requests, e.g. the blocks of a log commit.
+void
+bwrite_many(struct buf **bufs, int n)
+{
+  for(int i = 0; i < n; i++)
+    if(!holdingsleep(&bufs[i]->lock))
+      panic("bwrite_many");
+  virtio_disk_rw_many(bufs, n, 1);
+}
+
+// Start reading blocks that are likely to be needed soon
+// into the cache, without waiting for the disk. Blocks
+// that are already cached are skipped. The disk interrupt
+// marks each buf valid and releases it; see bdone().
+void
+breadahead(uint dev, uint *blocknos, int n)
+{
+  struct buf *bufs[READAHEAD], *b;
+  int i, k = 0;
+
+  for(i = 0; i < n && k < READAHEAD; i++){
+    if((b = bget1(dev, blocknos[i], 1)) == 0)
+      continue;
+    b->async = 1;
+    bufs[k++] = b;
+  }
+  if(k > 0)
+    virtio_disk_readahead(bufs, k);
+}
+
+// Drop a reference to an unlocked buffer.
+// Stamp it with the release time for LRU eviction.
+static void
+bput(struct buf *b)
+{
+  int h;
+
+  h = BHASH(b->dev, b->blockno);
+  acquire(&bcache.bucketlock[h]);
+  b->refcnt--;
+  if (b->refcnt == 0) {
+    // no one is waiting for it.
+    b->timestamp = ticks;
+  }
+  release(&bcache.bucketlock[h]);
+}
+
 // Release a locked buffer.
-// Move to the head of the most-recently-used list.
 void
 brelse(struct buf *b)
 {
@@ -120,34 +257,33 @@ brelse(struct buf *b)
     panic("brelse");
 
   releasesleep(&b->lock);
+  bput(b);
+}
 
-  acquire(&bcache.lock);
-  b->refcnt--;
-  if (b->refcnt == 0) {
-    // no one is waiting for it.
-    b->next->prev = b->prev;
-    b->prev->next = b->next;
-    b->next = bcache.head.next;
-    b->prev = &bcache.head;
-    bcache.head.next->prev = b;
-    bcache.head.next = b;
-  }
-  
-  release(&bcache.lock);
+// Called by the disk interrupt when a read-ahead
+// request has finished. The buf is locked by the
+// process that started the read-ahead, not by us,
+// so release it without brelse()'s check.
+void
+bdone(struct buf *b)
+{
+  b->valid = 1;
+  releasesleep(&b->lock);
+  bput(b);
 }
 
 void
 bpin(struct buf *b) {
-  acquire(&bcache.lock);
+  int h = BHASH(b->dev, b->blockno);
+  acquire(&bcache.bucketlock[h]);
   b->refcnt++;
-  release(&bcache.lock);
+  release(&bcache.bucketlock[h]);
 }
 
 void
 bunpin(struct buf *b) {
-  acquire(&bcache.lock);
+  int h = BHASH(b->dev, b->blockno);
+  acquire(&bcache.bucketlock[h]);
   b->refcnt--;
-  release(&bcache.lock);
+  release(&bcache.bucketlock[h]);
 }
-
-
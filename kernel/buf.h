@@ -1,12 +1,13 @@
 struct buf {
   int valid;   // has data been read from disk?
   int disk;    // does disk "own" buf?
+  int async;   // read-ahead: disk interrupt releases buf when done
   uint dev;
   uint blockno;
   struct sleeplock lock;
   uint refcnt;
-  struct buf *prev; // LRU cache list
-  struct buf *next;
+  uint timestamp;   // ticks at last brelse, for LRU eviction
+  struct buf *next; // hash bucket list
   uchar data[BSIZE];
 };
 
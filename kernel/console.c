@@ -100,6 +100,8 @@ consoleread(int user_dst, uint64 dst, int n)
         return -1;
       }
       sleep(&cons.r, &cons.lock);
+      // a process waiting for the keyboard is interactive.
+      prioboost();
     }
 
     c = cons.buf[cons.r++ % INPUT_BUF_SIZE];
@@ -1,19 +1,27 @@
 struct buf;
 struct context;
 struct file;
+struct icachestat;
 struct inode;
+struct lockclass;
 struct pipe;
 struct proc;
+struct shmseg;
 struct spinlock;
 struct sleeplock;
 struct stat;
 struct superblock;
+struct traceev;
+struct vma;
 
 // bio.c
 void            binit(void);
 struct buf*     bread(uint, uint);
 void            brelse(struct buf*);
 void            bwrite(struct buf*);
+void            bwrite_many(struct buf**, int);
+void            breadahead(uint, uint*, int);
+void            bdone(struct buf*);
 void            bpin(struct buf*);
 void            bunpin(struct buf*);
 
@@ -24,6 +32,7 @@ void            consputc(int);
 
 // exec.c
 int             kexec(char*, char**);
+int             kexecproc(struct proc*, char*, char**);
 
 // file.c
 struct file*    filealloc(void);
@@ -33,11 +42,14 @@ void            fileinit(void);
 int             fileread(struct file*, uint64, int n);
 int             filestat(struct file*, uint64 addr);
 int             filewrite(struct file*, uint64, int n);
+int             filesplice(struct file*, struct file*, int n);
 
 // fs.c
 void            fsinit(int);
 int             dirlink(struct inode*, char*, uint);
 struct inode*   dirlookup(struct inode*, char*, uint*);
+void            dcache_remove(struct inode*, char*);
+void            icachestat(struct icachestat*);
 struct inode*   ialloc(uint, short);
 struct inode*   idup(struct inode*);
 void            iinit();
@@ -59,18 +71,22 @@ void            ireclaim(int);
 void*           kalloc(void);
 void            kfree(void *);
 void            kinit(void);
+void            krefinc(void *);
+int             krefcnt(void *);
+void*           megaalloc(void);
 
 // log.c
 void            initlog(int, struct superblock*);
 void            log_write(struct buf*);
 void            begin_op(void);
 void            end_op(void);
+void            log_sync(void);
 
 // pipe.c
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
-int             piperead(struct pipe*, uint64, int);
-int             pipewrite(struct pipe*, uint64, int);
+int             piperead(struct pipe*, int, uint64, int);
+int             pipewrite(struct pipe*, int, uint64, int);
 
 // printf.c
 int             printf(char*, ...) __attribute__ ((format (printf, 1, 2)));
@@ -81,6 +97,11 @@ void            printfinit(void);
 int             cpuid(void);
 void            kexit(int);
 int             kfork(void);
+int             kspawn(char*, char**, int*, int);
+void            kthread(void (*)(void), char*);
+void            mlfqboost(void);
+void            prioboost(void);
+int             setnice(int, int);
 int             growproc(int);
 void            proc_mapstacks(pagetable_t);
 pagetable_t     proc_pagetable(struct proc *);
@@ -101,8 +122,13 @@ void            yield(void);
 int             either_copyout(int user_dst, uint64 dst, void *src, uint64 len);
 int             either_copyin(void *dst, int user_src, uint64 src, uint64 len);
 void            procdump(void);
-void            shm_init(void);
-void            shm_proc_exit(struct proc*);
+
+// prof.c
+extern uint64   profint;
+void            profinit(void);
+int             profset(int);
+void            profsample(void);
+int             profread(uint64, int);
 
 // swtch.S
 void            swtch(struct context*, struct context*);
@@ -114,6 +140,18 @@ void            initlock(struct spinlock*, char*);
 void            release(struct spinlock*);
 void            push_off(void);
 void            pop_off(void);
+struct lockclass* lockclassof(char*, int);
+void            lockcount(struct lockclass*, int, uint64);
+int             lockstatread(uint64, int);
+
+// shm.c
+void            shminit(void);
+struct shmseg*  shmget(char*, uint64);
+struct shmseg*  shmfile(struct inode*);
+uint64          shmsize(struct shmseg*);
+void            shmdup(struct shmseg*);
+void            shmput(struct shmseg*);
+uint64          shmpage(struct shmseg*, uint64, int*);
 
 // sleeplock.c
 void            acquiresleep(struct sleeplock*);
@@ -145,6 +183,22 @@ void            trapinithart(void);
 extern struct spinlock tickslock;
 void            prepare_return(void);
 
+// timer.c
+void            timeoutinit(void);
+int             sleepuntil(uint64);
+void            timeoutintr(void);
+void            timerarm(int);
+int             timertick(void);
+
+// trace.c
+void            traceinit(void);
+void            tracerecord(struct traceev*);
+void            tracexit(struct proc*, int);
+int             traceread(uint64, int);
+uint64          latstart(int*);
+void            latrecord(int, int, uint64);
+int             latread(uint64);
+
 // uart.c
 void            uartinit(void);
 void            uartintr(void);
@@ -152,6 +206,16 @@ void            uartwrite(char [], int);
 void            uartputc_sync(int);
 int             uartgetc(void);
 
+// vma.c
+struct vma*     vmafind(struct proc*, uint64);
+uint64          vmalow(struct proc*);
+struct vma*     vmaalloc(struct proc*, uint64, uint64, int, int, struct file*, uint);
+uint64          vmafault(struct proc*, uint64, int);
+void            vmaprefault(struct proc*, uint64, uint64);
+int             vmaunmap(struct proc*, uint64, uint64);
+void            vmaexit(struct proc*);
+int             vmacopy(struct proc*, struct proc*);
+
 // vm.c
 void            kvminit(void);
 void            kvminithart(void);
@@ -161,6 +225,8 @@ pagetable_t     uvmcreate(void);
 uint64          uvmalloc(pagetable_t, uint64, uint64, int);
 uint64          uvmdealloc(pagetable_t, uint64, uint64);
 int             uvmcopy(pagetable_t, pagetable_t, uint64);
+int             uvmshare(pagetable_t, pagetable_t, uint64, uint64, int);
+int             uvmdemote(pagetable_t, uint64);
 void            uvmfree(pagetable_t, uint64);
 void            uvmunmap(pagetable_t, uint64, uint64, int);
 void            uvmclear(pagetable_t, uint64);
@@ -171,6 +237,8 @@ int             copyin(pagetable_t, char *, uint64, uint64);
 int             copyinstr(pagetable_t, char *, uint64, uint64);
 int             ismapped(pagetable_t, uint64);
 uint64          vmfault(pagetable_t, uint64, int);
+int             lazyfault(struct proc*, uint64);
+int             cowfault(pagetable_t, uint64);
 void            vmprint(pagetable_t);
 
 // plic.c
@@ -182,6 +250,8 @@ void            plic_complete(int);
 // virtio_disk.c
 void            virtio_disk_init(void);
 void            virtio_disk_rw(struct buf *, int);
+void            virtio_disk_rw_many(struct buf **, int, int);
+void            virtio_disk_readahead(struct buf **, int);
 void            virtio_disk_intr(void);
 
 // number of elements in fixed-size array
@@ -25,6 +25,15 @@ int flags2perm(int flags)
 //
 int
 kexec(char *path, char **argv)
+{
+  return kexecproc(myproc(), path, argv);
+}
+
+// replace p's user image with the program at path.
+// p is either the caller (exec) or a new process
+// that hasn't run yet (spawn).
+int
+kexecproc(struct proc *p, char *path, char **argv)
 {
   char *s, *last;
   int i, off;
@@ -33,7 +42,6 @@ kexec(char *path, char **argv)
   struct inode *ip;
   struct proghdr ph;
   pagetable_t pagetable = 0, oldpagetable;
-  struct proc *p = myproc();
 
   begin_op();
 
@@ -78,7 +86,6 @@ kexec(char *path, char **argv)
   end_op();
   ip = 0;
 
-  p = myproc();
   uint64 oldsz = p->sz;
 
   // Allocate some pages at the next page boundary.
@@ -128,6 +135,7 @@ kexec(char *path, char **argv)
   safestrcpy(p->name, last, sizeof(p->name));
     
   // Commit to the user image.
+  vmaexit(p);
   oldpagetable = p->pagetable;
   p->pagetable = pagetable;
   p->sz = sz;
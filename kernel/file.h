@@ -18,15 +18,27 @@ struct inode {
   uint dev;           // Device number
   uint inum;          // Inode number
   int ref;            // Reference count
+  struct inode *hnext;  // itable hash chain
+  struct inode *fprev;  // itable free list, if ref is 0
+  struct inode *fnext;
   struct sleeplock lock; // protects everything below here
   int valid;          // inode has been read from disk?
 
+  uint ra_next;       // block a sequential readi() would read next
+  uint ra_end;        // read-ahead has been started up to here
+  uint ra_win;        // current read-ahead window, in blocks
+  uint map_idx;       // which double-indirect entry map_blk is
+  uint map_blk;       // last second-level block bmap() used, or 0
+  uint run_bn;        // file block that continues the last run
+  uint run_addr;      // disk block reserved for run_bn, or the goal
+  uint run_left;      // blocks still reserved, see bmapdata()
+
   short type;         // copy of disk inode
   short major;
   short minor;
   short nlink;
   uint size;
-  uint addrs[NDIRECT+1];
+  uint addrs[NDIRECT+2];
 };
 
 // map major device number to device functions.
@@ -37,6 +37,8 @@ readsb(int dev, struct superblock *sb)
   brelse(bp);
 }
 
+static void bhintinit(int);
+
 // Init fs
 void
 fsinit(int dev) {
@@ -44,6 +46,7 @@ fsinit(int dev) {
   if(sb.magic != FSMAGIC)
     panic("invalid file system");
   initlog(dev, &sb);
+  bhintinit(dev);
   ireclaim(dev);
 }
 
@@ -61,33 +64,134 @@ bzero(int dev, int bno)
 
 // Blocks.
 
-// Allocate a zeroed disk block.
-// returns 0 if out of disk space.
-static uint
-balloc(uint dev)
+// Free-block allocation hint, so balloc() does not have to
+// scan the bitmap from block 0. free[i] counts the free blocks
+// described by bitmap block i, and allocation resumes at next,
+// just after the last block handed out. The counts only change
+// while the bitmap block's buffer is locked.
+struct {
+  struct spinlock lock;
+  uint next;               // where to start looking
+  uint nfree;              // free blocks on the disk
+  uint free[FSSIZE/BPB+1]; // free blocks per bitmap block
+} bhint;
+
+// Count free blocks in the bitmap.
+static void
+bhintinit(int dev)
 {
-  int b, bi, m;
+  int b, bi;
   struct buf *bp;
 
-  bp = 0;
+  if(sb.size > FSSIZE)
+    panic("bhintinit: file system too big");
+  initlock(&bhint.lock, "bhint");
   for(b = 0; b < sb.size; b += BPB){
     bp = bread(dev, BBLOCK(b, sb));
     for(bi = 0; bi < BPB && b + bi < sb.size; bi++){
-      m = 1 << (bi % 8);
-      if((bp->data[bi/8] & m) == 0){  // Is block free?
-        bp->data[bi/8] |= m;  // Mark block in use.
-        log_write(bp);
+      if((bp->data[bi/8] & (1 << (bi % 8))) == 0)
+        bhint.free[b/BPB]++;
+    }
+    bhint.nfree += bhint.free[b/BPB];
+    brelse(bp);
+  }
+}
+
+// Allocate up to *n contiguous free blocks from bitmap
+// block bp, starting at block b if it is free. Sets *n to
+// the number allocated. Caller must hold bp's lock.
+static uint
+btake(struct buf *bp, uint b, uint *n)
+{
+  uint bi, cnt;
+
+  for(cnt = 0; cnt < *n && b + cnt < sb.size; cnt++){
+    bi = (b + cnt) % BPB;
+    if(cnt > 0 && bi == 0)
+      break;  // run reaches the next bitmap block
+    if(bp->data[bi/8] & (1 << (bi % 8)))
+      break;
+    bp->data[bi/8] |= 1 << (bi % 8);  // Mark block in use.
+  }
+  *n = cnt;
+  if(cnt == 0)
+    return 0;
+  log_write(bp);
+  acquire(&bhint.lock);
+  bhint.free[b/BPB] -= cnt;
+  bhint.nfree -= cnt;
+  bhint.next = b + cnt < sb.size ? b + cnt : 0;
+  release(&bhint.lock);
+  return b;
+}
+
+// Allocate up to *n contiguous disk blocks, at goal if that
+// block is free, else at the first free block from the hint
+// on. Sets *n to the number allocated. Does not zero them.
+// returns 0 if out of disk space.
+static uint
+balloc_range(uint dev, uint goal, uint *n)
+{
+  uint b, start, want, i, nbmap, free;
+  struct buf *bp;
+
+  acquire(&bhint.lock);
+  free = bhint.nfree;
+  start = bhint.next;
+  release(&bhint.lock);
+  if(free == 0)
+    goto full;
+
+  want = *n;
+  if(goal > 0 && goal < sb.size){
+    bp = bread(dev, BBLOCK(goal, sb));
+    b = btake(bp, goal, n);
+    brelse(bp);
+    if(b)
+      return b;
+  }
+
+  // Visit each bitmap block once, starting with the one
+  // holding the hint, and that one again from its start.
+  nbmap = (sb.size + BPB - 1) / BPB;
+  for(i = 0; i <= nbmap; i++){
+    b = ((start / BPB + i) % nbmap) * BPB;
+    if(i == 0)
+      b = start;
+    acquire(&bhint.lock);
+    free = bhint.free[b/BPB];
+    release(&bhint.lock);
+    if(free == 0)
+      continue;
+    bp = bread(dev, BBLOCK(b, sb));
+    for(; b < sb.size; b++){
+      *n = want;
+      if(btake(bp, b, n)){
         brelse(bp);
-        bzero(dev, b + bi);
-        return b + bi;
+        return b;
       }
+      if((b + 1) % BPB == 0)
+        break;
     }
     brelse(bp);
   }
+full:
   printf("balloc: out of blocks\n");
   return 0;
 }
 
+// Allocate a zeroed disk block.
+// returns 0 if out of disk space.
+static uint
+balloc(uint dev)
+{
+  uint b, n = 1;
+
+  if((b = balloc_range(dev, 0, &n)) != 0)
+    bzero(dev, b);
+  return b;
+}
+
 // Free a disk block.
 static void
 bfree(int dev, uint b)
@@ -102,6 +206,10 @@ bfree(int dev, uint b)
     panic("freeing free block");
   bp->data[bi/8] &= ~m;
   log_write(bp);
+  acquire(&bhint.lock);
+  bhint.free[b/BPB]++;
+  bhint.nfree++;
+  release(&bhint.lock);
   brelse(bp);
 }
 
@@ -135,13 +243,16 @@ bfree(int dev, uint b)
 //   the number of in-memory pointers to the entry (open
 //   files and current directories). iget() finds or
 //   creates a table entry and increments its ref; iput()
-//   decrements ref.
+//   decrements ref. Free entries stay in the table's hash
+//   chains, on an LRU free list, so iget() of a recently
+//   used inode can find it again without reading the disk;
+//   iget() recycles the least recently freed entry.
 //
 // * Valid: the information (type, size, &c) in an inode
 //   table entry is only correct when ip->valid is 1.
-//   ilock() reads the inode from
-//   the disk and sets ip->valid, while iput() clears
-//   ip->valid if ip->ref has fallen to zero.
+//   ilock() reads the inode from the disk and sets
+//   ip->valid, iput() clears it when it frees the inode,
+//   and iget() clears it when it recycles an entry.
 //
 // * Locked: file system code may only examine and modify
 //   the information in an inode and its content if it
@@ -174,23 +285,91 @@ bfree(int dev, uint b)
 // dev, and inum.  One must hold ip->lock in order to
 // read or write that inode's ip->valid, ip->size, ip->type, &c.
 
+#define NIHASH 31
+#define IHASH(dev, inum) (((dev) * 31 + (inum)) % NIHASH)
+
 struct {
   struct spinlock lock;
   struct inode inode[NINODE];
+  struct inode *bucket[NIHASH]; // chains through ip->hnext
+  struct inode free;            // list of ref == 0 entries,
+                                // least recently used first
+  uint64 hits;                  // iget() found the inode
+  uint64 misses;                // iget() recycled an entry
 } itable;
 
+// Directory name cache.
+//
+// Remembers the result of dirlookup(dp, name) as (dev, dp's
+// inum, name) -> (inum, offset of the dirent), so path walks
+// don't have to read every dirent of each directory. An entry
+// with inum 0 records that name is not in the directory.
+//
+// Entries for a directory only change while the directory's
+// ip->lock is held: dirlookup() adds them, dirlink() and
+// dcache_remove() (for unlink) update them, so a cached entry
+// always agrees with the directory's contents. When an inode
+// is freed, dcache_purge() drops entries in it or pointing to
+// it, since the inum may be reused.
+//
+// dcache.lock protects the hash chains and all entry fields.
+
+#define NDHASH 61
+#define DHASH(dev, dir, name) (dhash(dev, dir, name) % NDHASH)
+
+struct dentry {
+  uint dev;
+  uint dir;            // inum of the directory
+  char name[DIRSIZ];
+  uint inum;           // 0 if name is not in dir
+  uint off;            // byte offset of the dirent in dir
+  struct dentry *next; // hash chain
+};
+
+struct {
+  struct spinlock lock;
+  struct dentry ent[NDCACHE];
+  struct dentry *bucket[NDHASH];
+  int hand;            // next entry to recycle
+} dcache;
+
+// Put ip at the end of the free list.
+// Caller must hold itable.lock.
+static void
+ifree(struct inode *ip)
+{
+  ip->fprev = itable.free.fprev;
+  ip->fnext = &itable.free;
+  itable.free.fprev->fnext = ip;
+  itable.free.fprev = ip;
+}
+
+// Take ip off the free list.
+// Caller must hold itable.lock.
+static void
+iunfree(struct inode *ip)
+{
+  ip->fprev->fnext = ip->fnext;
+  ip->fnext->fprev = ip->fprev;
+}
+
 void
 iinit()
 {
   int i = 0;
   
   initlock(&itable.lock, "itable");
+  itable.free.fnext = itable.free.fprev = &itable.free;
   for(i = 0; i < NINODE; i++) {
     initsleeplock(&itable.inode[i].lock, "inode");
+    ifree(&itable.inode[i]);
   }
+  initlock(&dcache.lock, "dcache");
 }
 
 static struct inode* iget(uint dev, uint inum);
+static void dcache_purge(uint dev, uint inum);
+static void bmaprelease(struct inode *ip);
 
 // Allocate an inode on device dev.
 // Mark it as allocated by  giving it type type.
@@ -247,31 +426,43 @@ iupdate(struct inode *ip)
 static struct inode*
 iget(uint dev, uint inum)
 {
-  struct inode *ip, *empty;
+  struct inode *ip, **pp;
 
   acquire(&itable.lock);
 
   // Is the inode already in the table?
-  empty = 0;
-  for(ip = &itable.inode[0]; ip < &itable.inode[NINODE]; ip++){
-    if(ip->ref > 0 && ip->dev == dev && ip->inum == inum){
+  for(ip = itable.bucket[IHASH(dev, inum)]; ip; ip = ip->hnext){
+    if(ip->dev == dev && ip->inum == inum){
+      if(ip->ref == 0)
+        iunfree(ip);
       ip->ref++;
+      itable.hits++;
       release(&itable.lock);
       return ip;
     }
-    if(empty == 0 && ip->ref == 0)    // Remember empty slot.
-      empty = ip;
   }
 
-  // Recycle an inode entry.
-  if(empty == 0)
+  // Recycle the least recently used free entry.
+  ip = itable.free.fnext;
+  if(ip == &itable.free)
     panic("iget: no inodes");
+  iunfree(ip);
+  itable.misses++;
 
-  ip = empty;
+  if(ip->dev){
+    for(pp = &itable.bucket[IHASH(ip->dev, ip->inum)]; *pp != ip; pp = &(*pp)->hnext)
+      ;
+    *pp = ip->hnext;
+  }
   ip->dev = dev;
   ip->inum = inum;
+  ip->hnext = itable.bucket[IHASH(dev, inum)];
+  itable.bucket[IHASH(dev, inum)] = ip;
   ip->ref = 1;
   ip->valid = 0;
+  ip->ra_next = ip->ra_end = ip->ra_win = 0;
+  ip->map_blk = 0;
+  ip->run_bn = ip->run_addr = ip->run_left = 0;
   release(&itable.lock);
 
   return ip;
@@ -352,6 +543,7 @@ iput(struct inode *ip)
     ip->type = 0;
     iupdate(ip);
     ip->valid = 0;
+    dcache_purge(ip->dev, ip->inum);
 
     releasesleep(&ip->lock);
 
@@ -359,6 +551,25 @@ iput(struct inode *ip)
   }
 
   ip->ref--;
+  if(ip->ref == 0)
+    ifree(ip);
+  release(&itable.lock);
+}
+
+// Report inode table statistics.
+void
+icachestat(struct icachestat *st)
+{
+  struct inode *ip;
+
+  acquire(&itable.lock);
+  st->size = NINODE;
+  st->inuse = 0;
+  for(ip = itable.inode; ip < &itable.inode[NINODE]; ip++)
+    if(ip->ref > 0)
+      st->inuse++;
+  st->hits = itable.hits;
+  st->misses = itable.misses;
   release(&itable.lock);
 }
 
@@ -397,20 +608,84 @@ ireclaim(int dev)
 // The content (data) associated with each inode is stored
 // in blocks on the disk. The first NDIRECT block numbers
 // are listed in ip->addrs[].  The next NINDIRECT blocks are
-// listed in block ip->addrs[NDIRECT].
+// listed in block ip->addrs[NDIRECT]. The last NDINDIRECT
+// blocks go through two levels: block ip->addrs[NDIRECT+1]
+// lists NINDIRECT blocks, each of which lists NINDIRECT
+// data blocks.
+
+// Allocate a zeroed data block for file block bn. want is how
+// many blocks from bn on the caller is about to write; they are
+// reserved as one contiguous run, continuing the previous run
+// if possible, and handed out by later calls. The caller must
+// give unused ones back with bmaprelease().
+// returns 0 if out of disk space.
+static uint
+bmapdata(struct inode *ip, uint bn, uint want)
+{
+  uint addr, goal, n;
 
-// Return the disk block address of the nth block in inode ip.
-// If there is no such block, bmap allocates one.
+  if(ip->run_left == 0 || ip->run_bn != bn){
+    goal = bn == ip->run_bn ? ip->run_addr : 0;
+    bmaprelease(ip);
+    n = want;
+    if((addr = balloc_range(ip->dev, goal, &n)) == 0)
+      return 0;
+    ip->run_addr = addr;
+    ip->run_left = n;
+  }
+  addr = ip->run_addr;
+  ip->run_bn = bn + 1;
+  ip->run_addr++;
+  ip->run_left--;
+  bzero(ip->dev, addr);
+  return addr;
+}
+
+// Free the blocks bmapdata() reserved but did not use.
+// The next run will try to start at the first of them.
+static void
+bmaprelease(struct inode *ip)
+{
+  for(; ip->run_left > 0; ip->run_left--)
+    bfree(ip->dev, ip->run_addr + ip->run_left - 1);
+}
+
+// Return the address stored in slot i of indirect block
+// addr, allocating a block for the slot if it is empty:
+// data block bn if want > 0, else another indirect block.
 // returns 0 if out of disk space.
 static uint
-bmap(struct inode *ip, uint bn)
+bmapslot(struct inode *ip, uint addr, uint i, uint bn, uint want)
 {
-  uint addr, *a;
+  uint *a;
   struct buf *bp;
 
+  bp = bread(ip->dev, addr);
+  a = (uint*)bp->data;
+  if((addr = a[i]) == 0){
+    addr = want ? bmapdata(ip, bn, want) : balloc(ip->dev);
+    if(addr){
+      a[i] = addr;
+      log_write(bp);
+    }
+  }
+  brelse(bp);
+  return addr;
+}
+
+// Return the disk block address of the nth block in inode ip.
+// If there is no such block, bmap allocates one; want is the
+// number of blocks from bn on that the caller will write, and
+// is used to allocate them contiguously (see bmapdata()).
+// returns 0 if out of disk space.
+static uint
+bmap(struct inode *ip, uint bn, uint want)
+{
+  uint addr, idx, fbn = bn;
+
   if(bn < NDIRECT){
     if((addr = ip->addrs[bn]) == 0){
-      addr = balloc(ip->dev);
+      addr = bmapdata(ip, fbn, want);
       if(addr == 0)
         return 0;
       ip->addrs[bn] = addr;
@@ -427,30 +702,64 @@ bmap(struct inode *ip, uint bn)
         return 0;
       ip->addrs[NDIRECT] = addr;
     }
-    bp = bread(ip->dev, addr);
-    a = (uint*)bp->data;
-    if((addr = a[bn]) == 0){
-      addr = balloc(ip->dev);
-      if(addr){
-        a[bn] = addr;
-        log_write(bp);
+    return bmapslot(ip, addr, bn, fbn, want);
+  }
+  bn -= NINDIRECT;
+
+  if(bn < NDINDIRECT){
+    idx = bn / NINDIRECT;
+    if(ip->map_blk == 0 || ip->map_idx != idx){
+      // Load the double-indirect block to find the
+      // second-level block. Sequential access stays in one
+      // second-level block for NINDIRECT blocks, so remember
+      // it and skip this read next time.
+      if((addr = ip->addrs[NDIRECT+1]) == 0){
+        addr = balloc(ip->dev);
+        if(addr == 0)
+          return 0;
+        ip->addrs[NDIRECT+1] = addr;
       }
+      if((addr = bmapslot(ip, addr, idx, 0, 0)) == 0)
+        return 0;
+      ip->map_idx = idx;
+      ip->map_blk = addr;
     }
-    brelse(bp);
-    return addr;
+    return bmapslot(ip, ip->map_blk, bn % NINDIRECT, fbn, want);
   }
 
   panic("bmap: out of range");
 }
 
+// Free indirect block addr and the blocks it lists.
+// With depth > 1 the listed blocks are themselves
+// indirect blocks, one level down.
+static void
+itruncind(struct inode *ip, uint addr, int depth)
+{
+  int j;
+  struct buf *bp;
+  uint *a;
+
+  bp = bread(ip->dev, addr);
+  a = (uint*)bp->data;
+  for(j = 0; j < NINDIRECT; j++){
+    if(a[j]){
+      if(depth > 1)
+        itruncind(ip, a[j], depth - 1);
+      else
+        bfree(ip->dev, a[j]);
+    }
+  }
+  brelse(bp);
+  bfree(ip->dev, addr);
+}
+
 // Truncate inode (discard contents).
 // Caller must hold ip->lock.
 void
 itrunc(struct inode *ip)
 {
-  int i, j;
-  struct buf *bp;
-  uint *a;
+  int i;
 
   for(i = 0; i < NDIRECT; i++){
     if(ip->addrs[i]){
@@ -460,17 +769,17 @@ itrunc(struct inode *ip)
   }
 
   if(ip->addrs[NDIRECT]){
-    bp = bread(ip->dev, ip->addrs[NDIRECT]);
-    a = (uint*)bp->data;
-    for(j = 0; j < NINDIRECT; j++){
-      if(a[j])
-        bfree(ip->dev, a[j]);
-    }
-    brelse(bp);
-    bfree(ip->dev, ip->addrs[NDIRECT]);
+    itruncind(ip, ip->addrs[NDIRECT], 1);
     ip->addrs[NDIRECT] = 0;
   }
 
+  if(ip->addrs[NDIRECT+1]){
+    itruncind(ip, ip->addrs[NDIRECT+1], 2);
+    ip->addrs[NDIRECT+1] = 0;
+  }
+  ip->map_blk = 0;
+  ip->run_bn = ip->run_addr = 0;
+
   ip->size = 0;
   iupdate(ip);
 }
@@ -487,6 +796,43 @@ stati(struct inode *ip, struct stat *st)
   st->size = ip->size;
 }
 
+// Called by readi() before it reads blocks [bn, bn+nb).
+// If the inode is being read sequentially, start reading
+// the blocks after those in the background. The window
+// doubles on each sequential read, up to READAHEAD blocks,
+// and collapses on a seek.
+// Caller must hold ip->lock.
+static void
+readahead(struct inode *ip, uint bn, uint nb)
+{
+  uint blocks[READAHEAD], b, end, nblocks;
+  int n = 0;
+
+  // bn + 1 == ra_next: still reading the previous block,
+  // e.g. 512-byte read()s of 1024-byte blocks.
+  if(bn != ip->ra_next && bn + 1 != ip->ra_next){
+    // not sequential.
+    ip->ra_next = bn + nb;
+    ip->ra_end = 0;
+    ip->ra_win = 0;
+    return;
+  }
+  ip->ra_next = bn + nb;
+  ip->ra_win = ip->ra_win ? min(ip->ra_win * 2, READAHEAD) : 2;
+
+  nblocks = (ip->size + BSIZE - 1) / BSIZE;
+  end = min(bn + nb + ip->ra_win, nblocks);
+  for(b = bn + nb > ip->ra_end ? bn + nb : ip->ra_end; b < end && n < READAHEAD; b++){
+    if((blocks[n] = bmap(ip, b, 1)) == 0)
+      break;
+    n++;
+  }
+  if(b > ip->ra_end)
+    ip->ra_end = b;
+  if(n > 0)
+    breadahead(ip->dev, blocks, n);
+}
+
 // Read data from inode.
 // Caller must hold ip->lock.
 // If user_dst==1, then dst is a user virtual address;
@@ -501,9 +847,11 @@ readi(struct inode *ip, int user_dst, uint64 dst, uint off, uint n)
     return 0;
   if(off + n > ip->size)
     n = ip->size - off;
+  if(n > 0)
+    readahead(ip, off/BSIZE, (off+n-1)/BSIZE - off/BSIZE + 1);
 
   for(tot=0; tot<n; tot+=m, off+=m, dst+=m){
-    uint addr = bmap(ip, off/BSIZE);
+    uint addr = bmap(ip, off/BSIZE, 1);
     if(addr == 0)
       break;
     bp = bread(ip->dev, addr);
@@ -537,7 +885,9 @@ writei(struct inode *ip, int user_src, uint64 src, uint off, uint n)
     return -1;
 
   for(tot=0; tot<n; tot+=m, off+=m, src+=m){
-    uint addr = bmap(ip, off/BSIZE);
+    // blocks left to write, including this one.
+    uint want = (off + n - tot - 1)/BSIZE - off/BSIZE + 1;
+    uint addr = bmap(ip, off/BSIZE, want);
     if(addr == 0)
       break;
     bp = bread(ip->dev, addr);
@@ -549,6 +899,7 @@ writei(struct inode *ip, int user_src, uint64 src, uint off, uint n)
     log_write(bp);
     brelse(bp);
   }
+  bmaprelease(ip);
 
   if(off > ip->size)
     ip->size = off;
@@ -569,17 +920,120 @@ namecmp(const char *s, const char *t)
   return strncmp(s, t, DIRSIZ);
 }
 
+static uint
+dhash(uint dev, uint dir, char *name)
+{
+  uint h = dev * 31 + dir;
+  int i;
+
+  for(i = 0; i < DIRSIZ && name[i]; i++)
+    h = h * 31 + (uchar)name[i];
+  return h;
+}
+
+// Find the entry for name in directory dir.
+// Caller must hold dcache.lock.
+static struct dentry*
+dfind(uint dev, uint dir, char *name)
+{
+  struct dentry *d;
+
+  for(d = dcache.bucket[DHASH(dev, dir, name)]; d; d = d->next)
+    if(d->dev == dev && d->dir == dir && namecmp(d->name, name) == 0)
+      return d;
+  return 0;
+}
+
+// Unlink d from its hash chain.
+// Caller must hold dcache.lock.
+static void
+dunhash(struct dentry *d)
+{
+  struct dentry **pp;
+
+  for(pp = &dcache.bucket[DHASH(d->dev, d->dir, d->name)]; *pp; pp = &(*pp)->next){
+    if(*pp == d){
+      *pp = d->next;
+      break;
+    }
+  }
+  d->dev = 0;
+}
+
+// Record that name in directory dp is inode inum at
+// offset off, or (inum 0) that name is not in dp.
+// Caller must hold dp->lock.
+static void
+dcache_enter(struct inode *dp, char *name, uint inum, uint off)
+{
+  struct dentry *d;
+
+  acquire(&dcache.lock);
+  if((d = dfind(dp->dev, dp->inum, name)) == 0){
+    // recycle entries round-robin.
+    d = &dcache.ent[dcache.hand];
+    dcache.hand = (dcache.hand + 1) % NDCACHE;
+    if(d->dev)
+      dunhash(d);
+    d->dev = dp->dev;
+    d->dir = dp->inum;
+    strncpy(d->name, name, DIRSIZ);
+    d->next = dcache.bucket[DHASH(d->dev, d->dir, d->name)];
+    dcache.bucket[DHASH(d->dev, d->dir, d->name)] = d;
+  }
+  d->inum = inum;
+  d->off = off;
+  release(&dcache.lock);
+}
+
+// name has been removed from directory dp.
+// Caller must hold dp->lock.
+void
+dcache_remove(struct inode *dp, char *name)
+{
+  dcache_enter(dp, name, 0, 0);
+}
+
+// Inode inum on dev has been freed. Forget entries
+// in it (if it was a directory) and entries naming it.
+static void
+dcache_purge(uint dev, uint inum)
+{
+  struct dentry *d;
+
+  acquire(&dcache.lock);
+  for(d = dcache.ent; d < &dcache.ent[NDCACHE]; d++)
+    if(d->dev == dev && (d->dir == inum || d->inum == inum))
+      dunhash(d);
+  release(&dcache.lock);
+}
+
 // Look for a directory entry in a directory.
 // If found, set *poff to byte offset of entry.
+// Caller must hold dp->lock.
 struct inode*
 dirlookup(struct inode *dp, char *name, uint *poff)
 {
   uint off, inum;
   struct dirent de;
+  struct dentry *d;
 
   if(dp->type != T_DIR)
     panic("dirlookup not DIR");
 
+  acquire(&dcache.lock);
+  if((d = dfind(dp->dev, dp->inum, name)) != 0){
+    inum = d->inum;
+    off = d->off;
+    release(&dcache.lock);
+    if(inum == 0)
+      return 0;
+    if(poff)
+      *poff = off;
+    return iget(dp->dev, inum);
+  }
+  release(&dcache.lock);
+
   for(off = 0; off < dp->size; off += sizeof(de)){
     if(readi(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
       panic("dirlookup read");
@@ -590,10 +1044,12 @@ dirlookup(struct inode *dp, char *name, uint *poff)
       if(poff)
         *poff = off;
       inum = de.inum;
+      dcache_enter(dp, name, inum, off);
       return iget(dp->dev, inum);
     }
   }
 
+  dcache_enter(dp, name, 0, 0);
   return 0;
 }
 
@@ -624,6 +1080,7 @@ dirlink(struct inode *dp, char *name, uint inum)
   de.inum = inum;
   if(writei(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
     return -1;
+  dcache_enter(dp, name, inum, off);
 
   return 0;
 }
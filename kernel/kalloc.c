@@ -1,6 +1,24 @@
 // Physical memory allocator, for user processes,
 // kernel stacks, page-table pages,
 // and pipe buffers. Allocates whole 4096-byte pages.
+//
+// Each CPU has its own free list and lock, so that
+// kalloc()/kfree() on different CPUs don't contend.
+// A CPU whose list runs dry steals a batch of pages
+// from a sibling CPU.
+//
+// Every page also has a reference count, so that
+// copy-on-write fork can share a page between several
+// page tables; kfree() only really frees a page when
+// its last reference goes away.
+//
+// The top MEGAPAGES*MEGASIZE bytes of memory are kept apart
+// as 2-megabyte megapages for megaalloc(), since the free lists
+// soon hold no physically contiguous runs. A megapage's 4096-byte
+// pages are still freed one at a time with kfree(), and the
+// megapage goes back to the pool when the last of them does.
+// When the free lists are empty, kalloc() takes pages from the
+// pool as well, so it costs nothing while megapages aren't used.
 
 #include "types.h"
 #include "param.h"
@@ -9,7 +27,11 @@
 #include "riscv.h"
 #include "defs.h"
 
+// max pages moved from a sibling's free list per steal.
+#define KSTEAL 32
+
 void freerange(void *pa_start, void *pa_end);
+static void megaput(void *pa);
 
 extern char end[]; // first address after kernel.
                    // defined by kernel.ld.
@@ -18,16 +40,43 @@ struct run {
   struct run *next;
 };
 
+struct kmem {
+  struct spinlock lock;
+  struct run *freelist;
+};
+
+struct kmem kmem[NCPU];
+
+// start of the megapage pool.
+#define MEGABASE (PHYSTOP - (uint64)MEGAPAGES * MEGASIZE)
+
 struct {
   struct spinlock lock;
   struct run *freelist;
-} kmem;
+  int live[MEGAPAGES];  // pages of each megapage in use
+  struct run *pages[MEGAPAGES]; // free pages of each megapage in use
+} kmega;
+
+// reference counts of physical pages, indexed by
+// (pa - KERNBASE) / PGSIZE. updated with atomic
+// instructions rather than under a lock.
+#define PA2REF(pa) (((uint64)(pa) - KERNBASE) / PGSIZE)
+int krefs[(PHYSTOP - KERNBASE) / PGSIZE];
 
 void
 kinit()
 {
-  initlock(&kmem.lock, "kmem");
-  freerange(end, (void*)PHYSTOP);
+  struct run *r;
+
+  for(int i = 0; i < NCPU; i++)
+    initlock(&kmem[i].lock, "kmem");
+  initlock(&kmega.lock, "kmega");
+  freerange(end, (void*)MEGABASE);
+  for(uint64 pa = MEGABASE; pa < PHYSTOP; pa += MEGASIZE){
+    r = (struct run*)pa;
+    r->next = kmega.freelist;
+    kmega.freelist = r;
+  }
 }
 
 void
@@ -35,31 +84,135 @@ freerange(void *pa_start, void *pa_end)
 {
   char *p;
   p = (char*)PGROUNDUP((uint64)pa_start);
-  for(; p + PGSIZE <= (char*)pa_end; p += PGSIZE)
+  for(; p + PGSIZE <= (char*)pa_end; p += PGSIZE){
+    krefs[PA2REF(p)] = 1;
     kfree(p);
+  }
 }
 
 // Free the page of physical memory pointed at by pa,
 // which normally should have been returned by a
 // call to kalloc().  (The exception is when
 // initializing the allocator; see kinit above.)
+// Drops one reference; the page goes on the current
+// CPU's free list once nobody refers to it.
 void
 kfree(void *pa)
 {
   struct run *r;
+  int id, ref;
 
   if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
     panic("kfree");
 
+  ref = __sync_sub_and_fetch(&krefs[PA2REF(pa)], 1);
+  if(ref < 0)
+    panic("kfree: ref");
+  if(ref > 0)
+    return;
+
   // Fill with junk to catch dangling refs.
   memset(pa, 1, PGSIZE);
 
+  if((uint64)pa >= MEGABASE){
+    megaput(pa);
+    return;
+  }
+
   r = (struct run*)pa;
 
-  acquire(&kmem.lock);
-  r->next = kmem.freelist;
-  kmem.freelist = r;
-  release(&kmem.lock);
+  push_off();
+  id = cpuid();
+  acquire(&kmem[id].lock);
+  r->next = kmem[id].freelist;
+  kmem[id].freelist = r;
+  release(&kmem[id].lock);
+  pop_off();
+}
+
+// one page of a megapage is free; return the megapage
+// to the pool if it was the last one in use, otherwise
+// keep the page for megapage4k().
+static void
+megaput(void *pa)
+{
+  int i = ((uint64)pa - MEGABASE) / MEGASIZE;
+  struct run *r;
+
+  acquire(&kmega.lock);
+  if(--kmega.live[i] == 0){
+    kmega.pages[i] = 0;
+    r = (struct run*)(MEGABASE + (uint64)i * MEGASIZE);
+    r->next = kmega.freelist;
+    kmega.freelist = r;
+  } else {
+    r = (struct run*)pa;
+    r->next = kmega.pages[i];
+    kmega.pages[i] = r;
+  }
+  release(&kmega.lock);
+}
+
+// Take one 4096-byte page from the megapage pool, for kalloc()
+// once the free lists are empty: a free page of a megapage
+// already in use if there is one, otherwise the first page of
+// a free megapage, whose other pages are kept for later calls.
+// The page goes back to its megapage when freed.
+// Returns 0 if the pool is used up.
+static struct run *
+megapage4k(void)
+{
+  struct run *m, *r = 0;
+  uint64 off;
+  int i;
+
+  acquire(&kmega.lock);
+  for(i = 0; i < MEGAPAGES && kmega.pages[i] == 0; i++)
+    ;
+  if(i == MEGAPAGES && (m = kmega.freelist) != 0){
+    kmega.freelist = m->next;
+    i = ((uint64)m - MEGABASE) / MEGASIZE;
+    for(off = MEGASIZE; off > 0; off -= PGSIZE){
+      r = (struct run*)((char*)m + off - PGSIZE);
+      r->next = kmega.pages[i];
+      kmega.pages[i] = r;
+    }
+  }
+  if(i < MEGAPAGES){
+    r = kmega.pages[i];
+    kmega.pages[i] = r->next;
+    kmega.live[i]++;
+  }
+  release(&kmega.lock);
+  return r;
+}
+
+// Take up to KSTEAL pages from some other CPU's free list.
+// Returns a chain of pages, or 0 if every list is empty.
+// Holds only one kmem lock at a time, so two CPUs
+// stealing from each other can't deadlock.
+static struct run *
+ksteal(int id)
+{
+  struct run *r, *last;
+  int i, n;
+
+  for(i = 1; i < NCPU; i++){
+    struct kmem *k = &kmem[(id + i) % NCPU];
+    acquire(&k->lock);
+    r = k->freelist;
+    if(r){
+      last = r;
+      for(n = 1; n < KSTEAL && last->next; n++)
+        last = last->next;
+      k->freelist = last->next;
+      last->next = 0;
+      release(&k->lock);
+      return r;
+    }
+    release(&k->lock);
+  }
+  return 0;
 }
 
 // Allocate one 4096-byte page of physical memory.
@@ -69,14 +222,77 @@ void *
 kalloc(void)
 {
   struct run *r;
+  int id;
 
-  acquire(&kmem.lock);
-  r = kmem.freelist;
-  if(r)
-    kmem.freelist = r->next;
-  release(&kmem.lock);
+  push_off();
+  id = cpuid();
 
+  acquire(&kmem[id].lock);
+  r = kmem[id].freelist;
   if(r)
+    kmem[id].freelist = r->next;
+  release(&kmem[id].lock);
+
+  if(r == 0 && (r = ksteal(id)) != 0){
+    // keep the first stolen page, stash the rest locally.
+    acquire(&kmem[id].lock);
+    struct run *last = r;
+    while(last->next)
+      last = last->next;
+    last->next = kmem[id].freelist;
+    kmem[id].freelist = r->next;
+    release(&kmem[id].lock);
+  }
+  if(r == 0)
+    r = megapage4k();
+  pop_off();
+
+  if(r){
+    krefs[PA2REF(r)] = 1;
     memset((char*)r, 5, PGSIZE); // fill with junk
+  }
+  return (void*)r;
+}
+
+// Allocate a 2-megabyte, 2-megabyte-aligned megapage.
+// Each of its pages starts with one reference, and is
+// freed with kfree() like any other page.
+// Returns 0 if the pool is empty.
+void *
+megaalloc(void)
+{
+  struct run *r;
+  int i;
+
+  acquire(&kmega.lock);
+  r = kmega.freelist;
+  if(r){
+    kmega.freelist = r->next;
+    kmega.live[((uint64)r - MEGABASE) / MEGASIZE] = MEGASIZE / PGSIZE;
+  }
+  release(&kmega.lock);
+
+  if(r){
+    for(i = 0; i < MEGASIZE / PGSIZE; i++)
+      krefs[PA2REF((char*)r + i*PGSIZE)] = 1;
+  }
   return (void*)r;
 }
+
+// Add a reference to an allocated page, e.g. when
+// copy-on-write fork maps it into a second page table.
+void
+krefinc(void *pa)
+{
+  if(((uint64)pa % PGSIZE) != 0 || (char*)pa < end || (uint64)pa >= PHYSTOP)
+    panic("krefinc");
+  if(__sync_fetch_and_add(&krefs[PA2REF(pa)], 1) < 1)
+    panic("krefinc: free page");
+}
+
+// Return the number of references to an allocated page.
+int
+krefcnt(void *pa)
+{
+  return __atomic_load_n(&krefs[PA2REF(pa)], __ATOMIC_SEQ_CST);
+}
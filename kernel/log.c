@@ -19,7 +19,15 @@
 // its start and end. Usually begin_op() just increments
 // the count of in-progress FS system calls and returns.
 // But if it thinks the log is close to running out, it
-// sleeps until the last outstanding end_op() commits.
+// sleeps until the transaction has been committed.
+//
+// Commits are done by the log flusher kernel thread, not by
+// end_op(), so system calls don't wait for the disk. The flusher
+// commits whenever no FS system calls are active; operations
+// that begin before it gets to run join the open transaction,
+// so back-to-back and concurrent operations are grouped into
+// one commit. A caller that needs its updates on disk calls
+// log_sync() (the fsync() system call).
 //
 // The log is a physical re-do log containing disk blocks.
 // The on-disk log format:
@@ -28,7 +36,8 @@
 //   block B
 //   block C
 //   ...
-// Log appends are synchronous.
+// Log appends are synchronous, but the blocks of a commit
+// are handed to the disk in batches.
 
 // Contents of the header block, used for both the on-disk header block
 // and to keep track in memory of logged block# before commit.
@@ -42,6 +51,9 @@ struct log {
   int start;
   int outstanding; // how many FS sys calls are executing.
   int committing;  // in commit(), please wait.
+  int syncing;     // log_sync() wants a commit soon.
+  uint txn;        // number of the open transaction.
+  uint done;       // last transaction that is on disk.
   int dev;
   struct logheader lh;
 };
@@ -49,6 +61,7 @@ struct log log;
 
 static void recover_from_log(void);
 static void commit();
+static void flusher(void);
 
 void
 initlog(int dev, struct superblock *sb)
@@ -59,27 +72,39 @@ initlog(int dev, struct superblock *sb)
   initlock(&log.lock, "log");
   log.start = sb->logstart;
   log.dev = dev;
+  log.txn = 1;
   recover_from_log();
+  kthread(flusher, "logflush");
 }
 
-// Copy committed blocks from log to their home location
+// Copy committed blocks from log to their home location.
+// Home blocks are written LOGBATCH at a time, so the
+// disk has several writes in flight.
 static void
 install_trans(int recovering)
 {
-  int tail;
+  struct buf *dbufs[LOGBATCH];
+  int tail, i, n;
 
-  for (tail = 0; tail < log.lh.n; tail++) {
-    if(recovering) {
-      printf("recovering tail %d dst %d\n", tail, log.lh.block[tail]);
+  for (tail = 0; tail < log.lh.n; tail += n) {
+    n = log.lh.n - tail;
+    if(n > LOGBATCH)
+      n = LOGBATCH;
+    for (i = 0; i < n; i++) {
+      if(recovering) {
+        printf("recovering tail %d dst %d\n", tail+i, log.lh.block[tail+i]);
+      }
+      struct buf *lbuf = bread(log.dev, log.start+tail+i+1); // read log block
+      dbufs[i] = bread(log.dev, log.lh.block[tail+i]); // read dst
+      memmove(dbufs[i]->data, lbuf->data, BSIZE);  // copy block to dst
+      brelse(lbuf);
+    }
+    bwrite_many(dbufs, n);  // write dsts to disk
+    for (i = 0; i < n; i++) {
+      if(recovering == 0)
+        bunpin(dbufs[i]);
+      brelse(dbufs[i]);
     }
-    struct buf *lbuf = bread(log.dev, log.start+tail+1); // read log block
-    struct buf *dbuf = bread(log.dev, log.lh.block[tail]); // read dst
-    memmove(dbuf->data, lbuf->data, BSIZE);  // copy block to dst
-    bwrite(dbuf);  // write dst to disk
-    if(recovering == 0)
-      bunpin(dbuf);
-    brelse(lbuf);
-    brelse(dbuf);
   }
 }
 
@@ -129,7 +154,7 @@ begin_op(void)
 {
   acquire(&log.lock);
   while(1){
-    if(log.committing){
+    if(log.committing || log.syncing){
       sleep(&log, &log.lock);
     } else if(log.lh.n + (log.outstanding+1)*MAXOPBLOCKS > LOGBLOCKS){
       // this op might exhaust log space; wait for commit.
@@ -143,19 +168,17 @@ begin_op(void)
 }
 
 // called at the end of each FS system call.
-// commits if this was the last outstanding operation.
+// lets the flusher commit if this was the last
+// outstanding operation.
 void
 end_op(void)
 {
-  int do_commit = 0;
-
   acquire(&log.lock);
   log.outstanding -= 1;
   if(log.committing)
     panic("log.committing");
   if(log.outstanding == 0){
-    do_commit = 1;
-    log.committing = 1;
+    wakeup(&log.outstanding);
   } else {
     // begin_op() may be waiting for log space,
     // and decrementing log.outstanding has decreased
@@ -163,31 +186,85 @@ end_op(void)
     wakeup(&log);
   }
   release(&log.lock);
+}
+
+// Body of the log flusher thread: commit the open
+// transaction each time the FS system calls in it finish.
+static void
+flusher(void)
+{
+  uint txn;
+
+  acquire(&log.lock);
+  for(;;){
+    if(log.outstanding > 0 || log.lh.n == 0){
+      sleep(&log.outstanding, &log.lock);
+      continue;
+    }
+    log.committing = 1;
+    txn = log.txn++;
+    release(&log.lock);
 
-  if(do_commit){
     // call commit w/o holding locks, since not allowed
     // to sleep with locks.
     commit();
+
     acquire(&log.lock);
     log.committing = 0;
+    log.syncing = 0;
+    log.done = txn;
     wakeup(&log);
-    release(&log.lock);
   }
 }
 
-// Copy modified blocks from cache to log.
+// Wait until the updates of every FS system call that has
+// already finished are on disk. Must not be called inside
+// a transaction.
+void
+log_sync(void)
+{
+  uint target;
+
+  acquire(&log.lock);
+  if(log.committing){
+    // everything finished so far is in this commit.
+    target = log.txn - 1;
+  } else if(log.lh.n > 0){
+    // hold off new operations so the open
+    // transaction drains and gets committed.
+    target = log.txn;
+    log.syncing = 1;
+    if(log.outstanding == 0)
+      wakeup(&log.outstanding);
+  } else {
+    target = log.done;
+  }
+  while(log.done < target)
+    sleep(&log, &log.lock);
+  release(&log.lock);
+}
+
+// Copy modified blocks from cache to log,
+// LOGBATCH blocks per disk batch.
 static void
 write_log(void)
 {
-  int tail;
-
-  for (tail = 0; tail < log.lh.n; tail++) {
-    struct buf *to = bread(log.dev, log.start+tail+1); // log block
-    struct buf *from = bread(log.dev, log.lh.block[tail]); // cache block
-    memmove(to->data, from->data, BSIZE);
-    bwrite(to);  // write the log
-    brelse(from);
-    brelse(to);
+  struct buf *to[LOGBATCH];
+  int tail, i, n;
+
+  for (tail = 0; tail < log.lh.n; tail += n) {
+    n = log.lh.n - tail;
+    if(n > LOGBATCH)
+      n = LOGBATCH;
+    for (i = 0; i < n; i++) {
+      to[i] = bread(log.dev, log.start+tail+i+1); // log block
+      struct buf *from = bread(log.dev, log.lh.block[tail+i]); // cache block
+      memmove(to[i]->data, from->data, BSIZE);
+      brelse(from);
+    }
+    bwrite_many(to, n);  // write the log
+    for (i = 0; i < n; i++)
+      brelse(to[i]);
   }
 }
 
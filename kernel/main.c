@@ -27,6 +27,8 @@ main()
     binit();         // buffer cache
     iinit();         // inode table
     fileinit();      // file table
+    traceinit();     // system call trace rings
+    profinit();      // profiler sample rings
     virtio_disk_init(); // emulated hard disk
     userinit();      // first user process
     __sync_synchronize();
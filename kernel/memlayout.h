@@ -6,6 +6,11 @@
 
 #define RTC0 0x101000L
 
+// core local interruptor (CLINT); a CPU writes another's
+// MSIP to send it a software interrupt.
+#define CLINT 0x2000000L
+#define CLINT_MSIP(hart) (CLINT + 4*(hart))
+
 #define PLIC 0x0c000000L
 #define PLIC_PRIORITY (PLIC + 0x0)
 #define PLIC_PENDING (PLIC + 0x1000)
@@ -22,5 +27,6 @@
 
 #define TRAPFRAME (TRAMPOLINE - PGSIZE)
 
-// One user page reserved for explicit shared-memory mapping.
-#define SHM_VA (TRAPFRAME - PGSIZE)
+// mmap() regions and shared memory segments are placed
+// downward from here, above the heap.
+#define MMAPTOP TRAPFRAME
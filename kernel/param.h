@@ -1,15 +1,37 @@
 #define NPROC        64  // maximum number of processes
 #define NCPU          8  // maximum number of CPUs
 #define NOFILE       16  // open files per process
+#define NVMA         16  // mmap() regions per process
+#define NSHM         16  // shared memory segments per system
+#define SHMNAME      16  // max length of a segment name, including the 0
+#define SHMPAGES   8192  // max pages per shared memory segment
 #define NFILE       100  // open files per system
-#define NINODE       50  // maximum number of active i-nodes
+#define NINODE      200  // maximum number of cached i-nodes
+#define NDCACHE    1024  // cached directory name lookups
 #define NDEV         10  // maximum major device number
 #define ROOTDEV       1  // device number of file system root disk
 #define MAXARG       32  // max exec arguments
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGBLOCKS    (MAXOPBLOCKS*3)  // max data blocks in on-disk log
-#define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       2000  // size of file system in blocks
+#define NBUF         (MAXOPBLOCKS*6)  // size of disk block cache
+#define LOGBATCH     8     // log blocks written per disk batch
+#define READAHEAD    8     // max blocks of sequential read-ahead per inode
+#define FSSIZE       4000  // size of file system in blocks
 #define MAXPATH      128   // maximum file path name
 #define USERSTACK    1     // user stack pages
+#define PIPEPAGES    4     // pages of buffer per pipe (power of 2)
+#define NMLFQ        3     // scheduler priority levels
+#define MLFQTICKS    2     // timer ticks at level 0 before moving down
+#define MLFQBOOST    20    // ticks between priority boosts
+#define TICKTIME     1000000  // time CSR units per clock tick, about 0.1s
+#define TIMEFREQ     10000000 // time CSR units per second
+#define IDLETICKS    10    // max ticks an idle CPU skips
+#define FAULTAROUND  8     // default pages mapped per lazy page fault
+#define FAULTMAX     64    // max pages mapped per lazy page fault
+#define MEGAPAGES    8     // 2MB pages kept for megaalloc()
+#define NTRACE       256   // traced system calls buffered per CPU
+#define NPROF        1024  // profiler samples buffered per CPU
+#define PROFMIN      100   // shortest profiler interval, in microseconds
+#define NLOCKSTAT    64    // lock names counted by lockstat()
+#define LOCKNAME     16    // significant characters of a lock name
 
@@ -16,6 +16,7 @@ int nextpid = 1;
 struct spinlock pid_lock;
 
 extern void forkret(void);
+static void kthreadret(void);
 static void freeproc(struct proc *p);
 
 extern char trampoline[]; // trampoline.S
@@ -26,6 +27,151 @@ extern char trampoline[]; // trampoline.S
 // must be acquired before any p->lock.
 struct spinlock wait_lock;
 
+// Multi-level feedback queue. Each CPU has its own run
+// queues; RUNNABLE processes wait on runq[p->cpu].head[p->prio],
+// and scheduler() serves level 0 first. A CPU whose queues
+// are empty steals a process from another CPU before it idles.
+// A process that uses up its allotment of timer ticks at a
+// level moves down one level. Blocking on console input
+// moves it back up, as does a boost of every process each
+// MLFQBOOST ticks, so nothing starves. A process never rises
+// above level p->nice.
+//
+// A process is on a queue exactly when it is RUNNABLE, and
+// then p->cpu says which. runq[i].lock protects the queues of
+// CPU i and p->rqnext; it must be acquired after p->lock, and
+// no more than one is held at a time.
+struct runq {
+  struct spinlock lock;
+  struct proc *head[NMLFQ];
+  struct proc *tail[NMLFQ];
+} runq[NCPU];
+
+// Send CPU id a software interrupt, to wake it from the
+// wfi in scheduler(). See machinevec in kernelvec.S.
+static void
+cpuwake(int id)
+{
+  *(volatile uint32*)CLINT_MSIP(id) = 1;
+}
+
+// Append p to the run queue of its level on CPU p->cpu.
+// An idle CPU only looks at the queues when an interrupt
+// wakes it, so wake p->cpu if it is idle, or else, unless p
+// is just yielding this CPU, an idle one that can steal p.
+static void
+runqadd(struct proc *p)
+{
+  int id = p->cpu, i;
+  struct runq *q = &runq[id];
+
+  acquire(&q->lock);
+  p->rqnext = 0;
+  if(q->tail[p->prio])
+    q->tail[p->prio]->rqnext = p;
+  else
+    q->head[p->prio] = p;
+  q->tail[p->prio] = p;
+  release(&q->lock);
+
+  // pairs with scheduler() setting c->idle before it looks
+  // at the queues one last time.
+  if(__atomic_load_n(&cpus[id].idle, __ATOMIC_SEQ_CST)){
+    if(id != cpuid())
+      cpuwake(id);
+  } else if(p != myproc()){
+    for(i = 0; i < NCPU; i++){
+      if(i != cpuid() && __atomic_load_n(&cpus[i].idle, __ATOMIC_SEQ_CST)){
+        cpuwake(i);
+        break;
+      }
+    }
+  }
+}
+
+// Take p off its run queue. Returns 0 if p is not
+// there because a scheduler() has just taken it.
+static int
+runqdel(struct proc *p)
+{
+  struct runq *q = &runq[p->cpu];
+  struct proc **pp, *prev = 0;
+
+  acquire(&q->lock);
+  for(pp = &q->head[p->prio]; *pp; prev = *pp, pp = &(*pp)->rqnext){
+    if(*pp == p){
+      *pp = p->rqnext;
+      if(q->tail[p->prio] == p)
+        q->tail[p->prio] = prev;
+      release(&q->lock);
+      return 1;
+    }
+  }
+  release(&q->lock);
+  return 0;
+}
+
+// Remove and return the first process of the highest
+// non-empty level of q, or 0 if q is empty.
+static struct proc*
+runqpop(struct runq *q)
+{
+  struct proc *p = 0;
+  int i;
+
+  acquire(&q->lock);
+  for(i = 0; i < NMLFQ; i++){
+    if((p = q->head[i]) != 0){
+      q->head[i] = p->rqnext;
+      if(q->head[i] == 0)
+        q->tail[i] = 0;
+      break;
+    }
+  }
+  release(&q->lock);
+  return p;
+}
+
+// CPU id has nothing to run: take a process
+// from the first other CPU that has one.
+static struct proc*
+runqsteal(int id)
+{
+  struct proc *p;
+  int i;
+
+  for(i = 1; i < NCPU; i++)
+    if((p = runqpop(&runq[(id + i) % NCPU])) != 0)
+      return p;
+  return 0;
+}
+
+// Sleeping processes, hashed by wait channel, so wakeup()
+// only looks at processes sleeping on channels in one bucket.
+// A process is on sleepq[SQHASH(p->chan)] exactly when it is
+// SLEEPING. sleepq[i].lock protects the list, p->sqnext, and
+// p->chan of the processes on it; it must be acquired before
+// p->lock.
+#define NSLEEPQ 61
+#define SQHASH(chan) ((((uint64)(chan)) >> 3) % NSLEEPQ)
+
+struct sleepq {
+  struct spinlock lock;
+  struct proc *head;
+} sleepq[NSLEEPQ];
+
+// Mark p RUNNABLE and queue it on the CPU it last ran
+// on, or on this CPU if it has not run yet.
+// Caller must hold p->lock.
+static void
+setrunnable(struct proc *p)
+{
+  p->state = RUNNABLE;
+  if(p->cpu < 0)
+    p->cpu = cpuid();
+  runqadd(p);
+}
+
 // Allocate a page for each process's kernel stack.
 // Map it high in memory, followed by an invalid
 // guard page.
@@ -48,10 +194,15 @@ void
 procinit(void)
 {
   struct proc *p;
+  int i;
   
   initlock(&pid_lock, "nextpid");
   initlock(&wait_lock, "wait_lock");
-  shm_init();
+  for(i = 0; i < NCPU; i++)
+    initlock(&runq[i].lock, "runq");
+  for(i = 0; i < NSLEEPQ; i++)
+    initlock(&sleepq[i].lock, "sleepq");
+  shminit();
   for(p = proc; p < &proc[NPROC]; p++) {
       initlock(&p->lock, "proc");
       p->state = UNUSED;
@@ -149,6 +300,12 @@ found:
 
   // Inicializar contador de Page Faults en 0
   p->pf_count = 0;
+  p->pf_pages = 0;
+  p->faultaround = p->pf_window = FAULTAROUND;
+  p->pf_next = 0;
+
+  p->nice = p->prio = p->used = 0;
+  p->cpu = -1;
 
   return p;
 }
@@ -176,7 +333,6 @@ freeproc(struct proc *p)
   p->chan = 0;
   p->killed = 0;
   p->xstate = 0;
-  p->shm_attached = 0;
   p->trace_mask = 0; // EAFITos: Limpiar máscara strace
   p->map_ro_va = 0;
   p->state = UNUSED;
@@ -237,7 +393,7 @@ userinit(void)
   
   p->cwd = namei("/");
 
-  p->state = RUNNABLE;
+  setrunnable(p);
 
   release(&p->lock);
 }
@@ -252,13 +408,16 @@ growproc(int n)
 
   sz = p->sz;
   if(n > 0){
-    if(sz + n > SHM_VA) {
+    if(sz + n > vmalow(p)) {
       return -1;
     }
     if((sz = uvmalloc(p->pagetable, sz, sz + n, PTE_W)) == 0) {
       return -1;
     }
   } else if(n < 0){
+    // a megapage that stays in part must be split first.
+    if(PGROUNDUP(sz + n) % MEGASIZE && uvmdemote(p->pagetable, PGROUNDUP(sz + n)) < 0)
+      return -1;
     sz = uvmdealloc(p->pagetable, sz, sz + n);
   }
   p->sz = sz;
@@ -285,7 +444,13 @@ kfork(void)
     release(&np->lock);
     return -1;
   }
+  // set before vmacopy(), so freeproc() unmaps the heap if it fails.
   np->sz = p->sz;
+  if(vmacopy(p, np) < 0){
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
 
   // EAFITos: Heredar la máscara trace
   np->trace_mask = p->trace_mask;
@@ -304,6 +469,9 @@ kfork(void)
 
   safestrcpy(np->name, p->name, sizeof(p->name));
 
+  np->nice = np->prio = p->nice;
+  np->faultaround = np->pf_window = p->faultaround;
+
   pid = np->pid;
 
   release(&np->lock);
@@ -313,12 +481,98 @@ kfork(void)
   release(&wait_lock);
 
   acquire(&np->lock);
-  np->state = RUNNABLE;
+  setrunnable(np);
   release(&np->lock);
 
   return pid;
 }
 
+// Create a new process running the program at path,
+// without copying the caller's memory.
+// The child's file descriptor i is a dup of the caller's
+// fdmap[i], or closed if fdmap[i] < 0; fds at or beyond
+// nfd are closed. If fdmap is 0 the child inherits all of
+// the caller's open files, as with fork.
+// Returns the child's pid, or -1 on failure.
+int
+kspawn(char *path, char **argv, int *fdmap, int nfd)
+{
+  int i, pid, argc;
+  struct proc *np;
+  struct proc *p = myproc();
+
+  if(fdmap){
+    if(nfd < 0 || nfd > NOFILE)
+      return -1;
+    for(i = 0; i < nfd; i++)
+      if(fdmap[i] >= NOFILE || (fdmap[i] >= 0 && p->ofile[fdmap[i]] == 0))
+        return -1;
+  }
+
+  // Allocate process.
+  if((np = allocproc()) == 0){
+    return -1;
+  }
+
+  // kexecproc() reads the disk and so may sleep. np is not
+  // RUNNABLE and has no parent yet, so no one else uses it.
+  release(&np->lock);
+
+  memset(np->trapframe, 0, sizeof(*np->trapframe));
+  if((argc = kexecproc(np, path, argv)) < 0){
+    acquire(&np->lock);
+    freeproc(np);
+    release(&np->lock);
+    return -1;
+  }
+  // argc ends up in a0, as if returned from exec().
+  np->trapframe->a0 = argc;
+
+  np->trace_mask = p->trace_mask;
+  np->nice = np->prio = p->nice;
+  np->faultaround = np->pf_window = p->faultaround;
+
+  if(fdmap){
+    for(i = 0; i < nfd; i++)
+      if(fdmap[i] >= 0)
+        np->ofile[i] = filedup(p->ofile[fdmap[i]]);
+  } else {
+    for(i = 0; i < NOFILE; i++)
+      if(p->ofile[i])
+        np->ofile[i] = filedup(p->ofile[i]);
+  }
+  np->cwd = idup(p->cwd);
+
+  pid = np->pid;
+
+  acquire(&wait_lock);
+  np->parent = p;
+  release(&wait_lock);
+
+  acquire(&np->lock);
+  setrunnable(np);
+  release(&np->lock);
+
+  return pid;
+}
+
+// Start a kernel thread that runs fn() and never returns to
+// user space. It has no parent, so nobody waits for it, and
+// fn() must not return.
+void
+kthread(void (*fn)(void), char *name)
+{
+  struct proc *p;
+
+  if((p = allocproc()) == 0)
+    panic("kthread");
+  p->kfn = fn;
+  p->context.ra = (uint64)kthreadret;
+  safestrcpy(p->name, name, sizeof(p->name));
+  setrunnable(p);
+  release(&p->lock);
+}
+
 // Pass p's abandoned children to init.
 // Caller must hold wait_lock.
 void
@@ -345,7 +599,9 @@ kexit(int status)
   if(p == initproc)
     panic("init exiting");
 
-  shm_proc_exit(p);
+  vmaexit(p);
+  if(p->trace_mask)
+    tracexit(p, status);
 
   // Close all open files.
   for(int fd = 0; fd < NOFILE; fd++){
@@ -442,6 +698,7 @@ scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  int id = cpuid();
 
   c->proc = 0;
   for(;;){
@@ -453,28 +710,39 @@ scheduler(void)
     intr_on();
     intr_off();
 
-    int found = 0;
-    for(p = proc; p < &proc[NPROC]; p++) {
-      acquire(&p->lock);
-      if(p->state == RUNNABLE) {
-        // Switch to chosen process.  It is the process's job
-        // to release its lock and then reacquire it
-        // before jumping back to us.
-        p->state = RUNNING;
-        c->proc = p;
-        swtch(&c->context, &p->context);
-
-        // Process is done running for now.
-        // It should have changed its p->state before coming back.
-        c->proc = 0;
-        found = 1;
+    if((p = runqpop(&runq[id])) == 0 && (p = runqsteal(id)) == 0){
+      // nothing to run; stop running on this core until an
+      // interrupt, without clock ticks until a timeout is due.
+      // runqadd() wakes an idle CPU when there is work for it;
+      // look once more after saying so, in case it just missed.
+      __atomic_store_n(&c->idle, 1, __ATOMIC_SEQ_CST);
+      if((p = runqpop(&runq[id])) == 0 && (p = runqsteal(id)) == 0){
+        timerarm(1);
+        asm volatile("wfi");
+        continue;
       }
-      release(&p->lock);
     }
-    if(found == 0) {
-      // nothing to run; stop running on this core until an interrupt.
-      asm volatile("wfi");
+    if(c->idle){
+      // ticks again, to preempt p.
+      c->idle = 0;
+      timerarm(0);
     }
+
+    acquire(&p->lock);
+    if(p->state == RUNNABLE) {
+      // Switch to chosen process.  It is the process's job
+      // to release its lock and then reacquire it
+      // before jumping back to us.
+      p->state = RUNNING;
+      p->cpu = id;
+      c->proc = p;
+      swtch(&c->context, &p->context);
+
+      // Process is done running for now.
+      // It should have changed its p->state before coming back.
+      c->proc = 0;
+    }
+    release(&p->lock);
   }
 }
 
@@ -506,16 +774,92 @@ sched(void)
 }
 
 // Give up the CPU for one scheduling round.
+// Called on each timer interrupt, so also charge
+// the tick to p's allotment at its level.
 void
 yield(void)
 {
   struct proc *p = myproc();
   acquire(&p->lock);
-  p->state = RUNNABLE;
+  if(++p->used >= (MLFQTICKS << p->prio) && p->prio < NMLFQ-1){
+    p->prio++;
+    p->used = 0;
+  }
+  setrunnable(p);
   sched();
   release(&p->lock);
 }
 
+// Move p to level prio, requeueing it if it is waiting to run.
+// Caller must hold p->lock.
+static void
+setprio(struct proc *p, int prio)
+{
+  p->used = 0;
+  if(p->prio == prio)
+    return;
+  if(p->state == RUNNABLE && runqdel(p)){
+    p->prio = prio;
+    runqadd(p);
+  } else {
+    p->prio = prio;
+  }
+}
+
+// Put every process back at the top level it may use.
+// Called every MLFQBOOST ticks.
+void
+mlfqboost(void)
+{
+  struct proc *p;
+
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->state != UNUSED)
+      setprio(p, p->nice);
+    release(&p->lock);
+  }
+}
+
+// The current process has just received console input,
+// so it is interactive: move it to its top level.
+void
+prioboost(void)
+{
+  struct proc *p = myproc();
+
+  acquire(&p->lock);
+  setprio(p, p->nice);
+  release(&p->lock);
+}
+
+// Set the highest level process pid (0 for the caller)
+// may run at. Returns the old value, or -1.
+int
+setnice(int pid, int nice)
+{
+  struct proc *p;
+  int old;
+
+  if(nice < 0 || nice >= NMLFQ)
+    return -1;
+  if(pid == 0)
+    pid = myproc()->pid;
+  for(p = proc; p < &proc[NPROC]; p++){
+    acquire(&p->lock);
+    if(p->pid == pid && p->state != UNUSED){
+      old = p->nice;
+      p->nice = nice;
+      if(p->prio < nice)
+        setprio(p, nice);
+      release(&p->lock);
+      return old;
+    }
+    release(&p->lock);
+  }
+  return -1;
+}
+
 // A fork child's very first scheduling by scheduler()
 // will swtch to forkret.
 void
@@ -553,26 +897,46 @@ forkret(void)
   ((void (*)(uint64))trampoline_userret)(satp);
 }
 
+// A kernel thread's very first scheduling by scheduler()
+// will swtch to kthreadret.
+static void
+kthreadret(void)
+{
+  struct proc *p = myproc();
+
+  // Still holding p->lock from scheduler.
+  release(&p->lock);
+
+  p->kfn();
+  panic("kthread returned");
+}
+
 // Sleep on channel chan, releasing condition lock lk.
 // Re-acquires lk when awakened.
 void
 sleep(void *chan, struct spinlock *lk)
 {
   struct proc *p = myproc();
+  struct sleepq *q = &sleepq[SQHASH(chan)];
   
   // Must acquire p->lock in order to
   // change p->state and then call sched.
-  // Once we hold p->lock, we can be
+  // Once we hold q->lock, we can be
   // guaranteed that we won't miss any wakeup
-  // (wakeup locks p->lock),
+  // (wakeup locks q->lock and then p->lock,
+  // which we hold until sched() is done with us),
   // so it's okay to release lk.
 
-  acquire(&p->lock);  //DOC: sleeplock1
+  acquire(&q->lock);  //DOC: sleeplock1
+  acquire(&p->lock);
   release(lk);
 
   // Go to sleep.
   p->chan = chan;
   p->state = SLEEPING;
+  p->sqnext = q->head;
+  q->head = p;
+  release(&q->lock);
 
   sched();
 
@@ -589,17 +953,41 @@ sleep(void *chan, struct spinlock *lk)
 void
 wakeup(void *chan)
 {
-  struct proc *p;
+  struct sleepq *q = &sleepq[SQHASH(chan)];
+  struct proc *p, **pp;
 
-  for(p = proc; p < &proc[NPROC]; p++) {
-    if(p != myproc()){
+  acquire(&q->lock);
+  for(pp = &q->head; (p = *pp) != 0; ){
+    if(p->chan == chan){
+      *pp = p->sqnext;
       acquire(&p->lock);
-      if(p->state == SLEEPING && p->chan == chan) {
-        p->state = RUNNABLE;
-      }
+      setrunnable(p);
+      release(&p->lock);
+    } else {
+      pp = &p->sqnext;
+    }
+  }
+  release(&q->lock);
+}
+
+// Wake p if it is still on the sleep queue of chan.
+static void
+unsleep(struct proc *p, void *chan)
+{
+  struct sleepq *q = &sleepq[SQHASH(chan)];
+  struct proc **pp;
+
+  acquire(&q->lock);
+  for(pp = &q->head; *pp; pp = &(*pp)->sqnext){
+    if(*pp == p){
+      *pp = p->sqnext;
+      acquire(&p->lock);
+      setrunnable(p);
       release(&p->lock);
+      break;
     }
   }
+  release(&q->lock);
 }
 
 // Kill the process with the given pid.
@@ -609,16 +997,18 @@ int
 kkill(int pid)
 {
   struct proc *p;
+  void *chan;
 
   for(p = proc; p < &proc[NPROC]; p++){
     acquire(&p->lock);
     if(p->pid == pid){
       p->killed = 1;
-      if(p->state == SLEEPING){
+      chan = p->state == SLEEPING ? p->chan : 0;
+      release(&p->lock);
+      if(chan){
         // Wake process from sleep().
-        p->state = RUNNABLE;
+        unsleep(p, chan);
       }
-      release(&p->lock);
       return 0;
     }
     release(&p->lock);
@@ -700,7 +1090,7 @@ procdump(void)
       state = states[p->state];
     else
       state = "???";
-    printf("%d %s %s", p->pid, state, p->name);
+    printf("%d %s %s prio %d", p->pid, state, p->name, p->prio);
     printf("\n");
   }
 }
@@ -24,6 +24,8 @@ struct cpu {
   struct context context;     // swtch() here to enter scheduler().
   int noff;                   // Depth of push_off() nesting.
   int intena;                 // Were interrupts enabled before push_off()?
+  int idle;                   // In scheduler() with nothing to run.
+  uint64 tickat;              // time CSR of the next clock tick, see timerarm().
 };
 
 extern struct cpu cpus[NCPU];
@@ -81,9 +83,16 @@ struct trapframe {
 
 enum procstate { UNUSED, USED, SLEEPING, RUNNABLE, RUNNING, ZOMBIE };
 
-struct vregion {
-  uint64 start;
-  int size;
+// A region mapped by mmap(), see vma.c.
+struct vma {
+  uint64 start;                // page-aligned start address
+  uint64 len;                  // bytes, a multiple of PGSIZE; 0 if unused
+  int prot;                    // PROT_READ, PROT_WRITE, PROT_EXEC
+  int flags;                   // MAP_SHARED or MAP_PRIVATE, MAP_ANONYMOUS
+  struct file *f;              // mapped file, or 0 if anonymous
+  struct shmseg *seg;          // shared memory segment, or 0, see shm.c
+  uint off;                    // file or segment offset of start
+  char fill;                   // byte new anonymous pages hold
 };
 
 // Per-process state
@@ -93,9 +102,16 @@ struct proc {
   // p->lock must be held when using these:
   enum procstate state;        // Process state
   void *chan;                  // If non-zero, sleeping on chan
+  uint64 wakeat;               // sleepuntil() deadline, see timer.c
+  struct proc *sqnext;         // sleep queue link, see sleepq in proc.c
   int killed;                  // If non-zero, have been killed
   int xstate;                  // Exit status to be returned to parent's wait
   int pid;                     // Process ID
+  int prio;                    // MLFQ level, 0 runs first
+  int nice;                    // highest level p may run at
+  int used;                    // timer ticks used at this level
+  int cpu;                     // CPU p is queued on or last ran on, or -1
+  struct proc *rqnext;         // run queue link, see runq in proc.c
 
   // wait_lock must be held when using this:
   struct proc *parent;         // Parent process
@@ -106,12 +122,16 @@ struct proc {
   pagetable_t pagetable;       // User page table
   struct trapframe *trapframe; // data page for trampoline.S
   struct context context;      // swtch() here to run process
+  void (*kfn)(void);           // Body of a kernel thread, see kthread()
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
-  int shm_attached;            // shared-memory page mapped at SHM_VA
   char name[16];               // Process name (debugging)
-  int trace_mask;              // EAFITos: Máscara para strace
+  uint64 trace_mask;           // EAFITos: Máscara para strace, ver trace.c
   uint64 map_ro_va;            // VA de la página RO mapeada
   int pf_count;                // Contador de Page Faults (Lazy Allocation)
-  struct vregion vreg;         // Región simulada para mmap
+  uint64 pf_pages;             // pages mapped by those faults
+  int faultaround;             // pages per fault cluster, see lazyfault()
+  int pf_window;               // current cluster size in pages
+  uint64 pf_next;              // address just past the last cluster
+  struct vma vma[NVMA];        // mmap() regions
 };
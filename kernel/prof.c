@@ -0,0 +1,121 @@
+// Sampling profiler, for prof.
+//
+// While profiling is on (see profile()), each CPU that has
+// something to run takes an extra timer interrupt every
+// profint time CSR units, and clockintr() records the
+// interrupted pc, user or kernel, in a ring belonging to that
+// CPU. These extra interrupts are not clock ticks: they don't
+// preempt the running process or count against its MLFQ
+// allotment, see timerarm().
+//
+// The rings work as in trace.c: the CPU writes its own ring
+// with interrupts off and without a lock, readers take samples
+// under proflock, and a full ring counts what it drops in lost,
+// reported as a sample with pc 0 and the count in pid.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "prof.h"
+#include "defs.h"
+
+struct profring {
+  struct profsample s[NPROF];
+  uint64 head;   // next slot to write, written only by its CPU
+  uint64 tail;   // next slot to read, under proflock
+  uint64 lost;   // samples dropped because the ring was full
+};
+
+struct profring profring[NCPU];
+struct spinlock proflock;
+
+// time CSR units between samples, or 0 if not profiling.
+uint64 profint;
+
+void
+profinit(void)
+{
+  initlock(&proflock, "prof");
+}
+
+// set the sampling interval to us microseconds, or stop
+// profiling if us is 0; leave it alone if us < 0. a CPU picks
+// the change up at its next timer interrupt.
+// returns the old interval.
+int
+profset(int us)
+{
+  int old = profint * 1000000 / TIMEFREQ;
+
+  if(us >= 0)
+    __atomic_store_n(&profint, (uint64)us * TIMEFREQ / 1000000, __ATOMIC_RELAXED);
+  return old;
+}
+
+// record where this CPU was interrupted.
+// called from clockintr() with interrupts off.
+void
+profsample(void)
+{
+  struct profring *r = &profring[cpuid()];
+  struct profsample *s;
+  struct proc *p = myproc();
+
+  if(r->head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= NPROF){
+    __atomic_fetch_add(&r->lost, 1, __ATOMIC_RELAXED);
+    return;
+  }
+  s = &r->s[r->head % NPROF];
+  s->pc = r_sepc();
+  s->pid = p ? p->pid : 0;
+  s->cpu = cpuid();
+  s->user = (r_sstatus() & SSTATUS_SPP) == 0;
+  __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+// take up to n samples from ring r, after its lost count.
+static int
+proftake(struct profring *r, struct profsample *s, int n)
+{
+  uint64 lost;
+  int k = 0;
+
+  if(n > 0 && (lost = __atomic_exchange_n(&r->lost, 0, __ATOMIC_RELAXED)) != 0){
+    memset(&s[k], 0, sizeof(s[k]));
+    s[k].pid = lost;
+    s[k].cpu = r - profring;
+    k++;
+  }
+  for(; k < n && r->tail != __atomic_load_n(&r->head, __ATOMIC_ACQUIRE); k++){
+    s[k] = r->s[r->tail % NPROF];
+    __atomic_store_n(&r->tail, r->tail + 1, __ATOMIC_RELEASE);
+  }
+  return k;
+}
+
+// copy up to n samples to user address addr.
+// returns how many, or -1 on a bad address.
+int
+profread(uint64 addr, int n)
+{
+  struct profsample s[16];
+  struct profring *r;
+  int i, k, total = 0;
+
+  for(r = profring; r < &profring[NCPU] && total < n; ){
+    // copyout() may fault pages in, so not under proflock.
+    acquire(&proflock);
+    k = proftake(r, s, n - total < NELEM(s) ? n - total : NELEM(s));
+    release(&proflock);
+    for(i = 0; i < k; i++, total++)
+      if(copyout(myproc()->pagetable, addr + total*sizeof(s[0]),
+                 (char*)&s[i], sizeof(s[0])) < 0)
+        return -1;
+    if(k < NELEM(s))
+      r++;
+  }
+  return total;
+}
@@ -0,0 +1,8 @@
+// A profiler sample, as recorded by clockintr() and
+// returned by profread(). 16 bytes.
+struct profsample {
+  uint64 pc;       // interrupted program counter
+  int pid;         // running process, or 0 for none
+  short cpu;
+  short user;      // 1 if pc is a user address
+};
@@ -0,0 +1,205 @@
+// Named shared memory segments, for shm_open() and shm_close().
+//
+// A segment is a run of up to SHMPAGES pages, found by name. Each
+// process attaches it as a MAP_SHARED region (see vma.c) whose
+// v->seg points here, and seg->ref counts those regions, including
+// ones inherited across fork(). The pages are allocated when first
+// touched and are freed, along with the name, when the last region
+// goes away.
+//
+// The segment holds one reference to each of its pages, and each
+// mapping of a page another, so a page outlives the segment only
+// until it is unmapped.
+//
+// MAP_SHARED mappings of a file use an unnamed segment too, one per
+// inode (see shmfile()), so that every mapping of a file page, in
+// any process, maps the same physical page. vma.c reads such a
+// page in from the file when shmpage() first allocates it.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "fs.h"
+#include "defs.h"
+
+// page numbers per index page.
+#define SHMIDXN (PGSIZE / sizeof(uint64))
+
+// pages in the largest file.
+#define SHMFILEPAGES (((uint64)MAXFILE * BSIZE + PGSIZE - 1) / PGSIZE)
+
+#define SHMMAXPAGES (SHMFILEPAGES > SHMPAGES ? SHMFILEPAGES : SHMPAGES)
+
+struct shmseg {
+  char name[SHMNAME];
+  struct inode *ip;           // the file, for a file's segment
+  uint64 npages;
+  int ref;                    // regions attached, 0 if unused
+  uint64 *idx[(SHMMAXPAGES + SHMIDXN - 1) / SHMIDXN]; // pages, or 0
+};
+
+struct {
+  struct spinlock lock;
+  struct shmseg seg[NSHM];
+} shmtable;
+
+void
+shminit(void)
+{
+  initlock(&shmtable.lock, "shmtable");
+}
+
+// find the segment called name and take a reference to it,
+// or make one of npages pages if there is none. an existing
+// segment must have at least npages pages.
+// returns 0 if none can be found or made.
+struct shmseg*
+shmget(char *name, uint64 npages)
+{
+  struct shmseg *s, *free = 0;
+
+  if(npages > SHMPAGES)
+    return 0;
+  acquire(&shmtable.lock);
+  for(s = shmtable.seg; s < &shmtable.seg[NSHM]; s++){
+    if(s->ref == 0){
+      if(free == 0)
+        free = s;
+    } else if(s->ip == 0 && strncmp(s->name, name, SHMNAME) == 0){
+      if(npages > s->npages){
+        release(&shmtable.lock);
+        return 0;
+      }
+      s->ref++;
+      release(&shmtable.lock);
+      return s;
+    }
+  }
+  if(free == 0 || npages == 0){
+    release(&shmtable.lock);
+    return 0;
+  }
+  s = free;
+  safestrcpy(s->name, name, SHMNAME);
+  s->npages = npages;
+  s->ref = 1;
+  release(&shmtable.lock);
+  return s;
+}
+
+// find the segment holding ip's shared pages and take a
+// reference to it, or make one. the caller's region must hold
+// a reference to ip, through its file, for as long as it is
+// attached. returns 0 if there is no free segment.
+struct shmseg*
+shmfile(struct inode *ip)
+{
+  struct shmseg *s, *free = 0;
+
+  acquire(&shmtable.lock);
+  for(s = shmtable.seg; s < &shmtable.seg[NSHM]; s++){
+    if(s->ref == 0){
+      if(free == 0)
+        free = s;
+    } else if(s->ip == ip){
+      s->ref++;
+      release(&shmtable.lock);
+      return s;
+    }
+  }
+  if(free == 0){
+    release(&shmtable.lock);
+    return 0;
+  }
+  s = free;
+  s->name[0] = 0;
+  s->ip = ip;
+  s->npages = SHMFILEPAGES;
+  s->ref = 1;
+  release(&shmtable.lock);
+  return s;
+}
+
+uint64
+shmsize(struct shmseg *s)
+{
+  return s->npages * PGSIZE;
+}
+
+// take another reference to s, for fork() or for splitting
+// a region.
+void
+shmdup(struct shmseg *s)
+{
+  acquire(&shmtable.lock);
+  if(s->ref < 1)
+    panic("shmdup");
+  s->ref++;
+  release(&shmtable.lock);
+}
+
+// drop a reference to s, freeing it with the last one.
+void
+shmput(struct shmseg *s)
+{
+  int i, j;
+
+  acquire(&shmtable.lock);
+  if(s->ref < 1)
+    panic("shmput");
+  if(--s->ref == 0){
+    for(i = 0; i < NELEM(s->idx); i++){
+      if(s->idx[i] == 0)
+        continue;
+      for(j = 0; j < SHMIDXN; j++)
+        if(s->idx[i][j])
+          kfree((void*)s->idx[i][j]);
+      kfree((void*)s->idx[i]);
+      s->idx[i] = 0;
+    }
+    s->name[0] = 0;
+    s->ip = 0;
+    s->npages = 0;
+  }
+  release(&shmtable.lock);
+}
+
+// the physical address of page pn of s, allocating a zeroed
+// page the first time, with a new reference for the caller's
+// mapping. sets *fresh, if fresh isn't 0, to whether the page
+// was just allocated. returns 0 if out of memory.
+uint64
+shmpage(struct shmseg *s, uint64 pn, int *fresh)
+{
+  uint64 **ip, pa;
+
+  if(pn >= s->npages)
+    panic("shmpage");
+  acquire(&shmtable.lock);
+  if(fresh)
+    *fresh = 0;
+  ip = &s->idx[pn / SHMIDXN];
+  if(*ip == 0){
+    if((*ip = kalloc()) == 0){
+      release(&shmtable.lock);
+      return 0;
+    }
+    memset(*ip, 0, PGSIZE);
+  }
+  if((pa = (*ip)[pn % SHMIDXN]) == 0){
+    if((pa = (uint64)kalloc()) == 0){
+      release(&shmtable.lock);
+      return 0;
+    }
+    memset((void*)pa, 0, PGSIZE);
+    (*ip)[pn % SHMIDXN] = pa;
+    if(fresh)
+      *fresh = 1;
+  }
+  krefinc((void*)pa);
+  release(&shmtable.lock);
+  return pa;
+}
@@ -16,17 +16,24 @@ initsleeplock(struct sleeplock *lk, char *name)
   lk->name = name;
   lk->locked = 0;
   lk->pid = 0;
+  lk->class = lockclassof(name, 1);
 }
 
 void
 acquiresleep(struct sleeplock *lk)
 {
+  int contended;
+  uint64 start;
+
   acquire(&lk->lk);
+  contended = lk->locked;
+  start = r_time();
   while (lk->locked) {
     sleep(lk, &lk->lk);
   }
   lk->locked = 1;
   lk->pid = myproc()->pid;
+  lockcount(lk->class, contended, contended ? r_time() - start : 0);
   release(&lk->lk);
 }
 
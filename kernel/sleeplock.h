@@ -6,5 +6,7 @@ struct sleeplock {
   // For debugging:
   char *name;        // Name of lock.
   int pid;           // Process holding lock
+
+  struct lockclass *class; // Statistics for locks of this name, or 0.
 };
 
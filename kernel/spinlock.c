@@ -1,4 +1,14 @@
 // Mutual exclusion spin locks.
+//
+// Every lock also counts, in the lockclass for its name, how often
+// it is acquired, how often it was already held, and how long those
+// acquisitions waited for it, for lockstat(): in cycles for a spin
+// lock, and in time CSR units for a sleep lock, since its waiter
+// may sleep on one CPU and wake on another, whose cycle count is
+// its own. Locks share a class with all others of their name, e.g.
+// all the "proc" locks. The counts are kept per CPU, each CPU's in a cache line of
+// its own, and updated with the lock held and interrupts off, so
+// they need no lock of their own and CPUs don't fight over them.
 
 #include "types.h"
 #include "param.h"
@@ -6,14 +16,93 @@
 #include "spinlock.h"
 #include "riscv.h"
 #include "proc.h"
+#include "stat.h"
 #include "defs.h"
 
+struct lockclass {
+  char *name;        // 0 if unused
+  int sleep;         // a class of sleep locks?
+  struct {
+    uint64 acquires;
+    uint64 contended;
+    uint64 wait;     // cycles or time spent waiting
+  } __attribute__ ((aligned (64))) cpu[NCPU];
+};
+
+struct lockclass lockclass[NLOCKSTAT];
+
+// find the class for locks called name, making one if
+// there is none. returns 0 if the table is full.
+// initlock() may run on several CPUs at once, so
+// slots are claimed with an atomic swap.
+struct lockclass*
+lockclassof(char *name, int sleep)
+{
+  struct lockclass *c;
+
+  for(c = lockclass; c < &lockclass[NLOCKSTAT]; c++){
+    if(c->name == 0 && __sync_bool_compare_and_swap(&c->name, 0, name)){
+      c->sleep = sleep;
+      return c;
+    }
+    if(strncmp(c->name, name, LOCKNAME) == 0)
+      return c;
+  }
+  return 0;
+}
+
+// count an acquisition of a lock of class c that waited
+// wait cycles, or time CSR units for a sleep lock, if
+// contended. interrupts must be off.
+void
+lockcount(struct lockclass *c, int contended, uint64 wait)
+{
+  int id = cpuid();
+
+  if(c == 0)
+    return;
+  c->cpu[id].acquires++;
+  if(contended){
+    c->cpu[id].contended++;
+    c->cpu[id].wait += wait;
+  }
+}
+
+// copy the statistics of up to n lock classes, summed
+// over CPUs, to the user array of struct lockstat at addr.
+// returns how many, or -1 on a bad address.
+int
+lockstatread(uint64 addr, int n)
+{
+  struct lockclass *c;
+  struct lockstat st;
+  int i, k = 0;
+
+  for(c = lockclass; c < &lockclass[NLOCKSTAT] && k < n; c++){
+    if(c->name == 0)
+      break;
+    memset(&st, 0, sizeof(st));
+    safestrcpy(st.name, c->name, sizeof(st.name));
+    st.sleep = c->sleep;
+    for(i = 0; i < NCPU; i++){
+      st.acquires += c->cpu[i].acquires;
+      st.contended += c->cpu[i].contended;
+      st.wait += c->cpu[i].wait;
+    }
+    if(copyout(myproc()->pagetable, addr + k*sizeof(st), (char*)&st, sizeof(st)) < 0)
+      return -1;
+    k++;
+  }
+  return k;
+}
+
 void
 initlock(struct spinlock *lk, char *name)
 {
   lk->name = name;
   lk->locked = 0;
   lk->cpu = 0;
+  lk->class = lockclassof(name, 0);
 }
 
 // Acquire the lock.
@@ -21,6 +110,9 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  int contended = 0;
+  uint64 start = 0;
+
   push_off(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
@@ -29,8 +121,13 @@ acquire(struct spinlock *lk)
   //   a5 = 1
   //   s1 = &lk->locked
   //   amoswap.w.aq a5, a5, (s1)
-  while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
-    ;
+  if(__sync_lock_test_and_set(&lk->locked, 1) != 0){
+    // held by another CPU; time the wait, for lockstat().
+    contended = 1;
+    start = r_cycle();
+    while(__sync_lock_test_and_set(&lk->locked, 1) != 0)
+      ;
+  }
 
   // Tell the C compiler and the processor to not move loads or stores
   // past this point, to ensure that the critical section's memory
@@ -40,6 +137,7 @@ acquire(struct spinlock *lk)
 
   // Record info about lock acquisition for holding() and debugging.
   lk->cpu = mycpu();
+  lockcount(lk->class, contended, contended ? r_cycle() - start : 0);
 }
 
 // Release the lock.
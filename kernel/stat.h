@@ -9,3 +9,28 @@ struct stat {
   short nlink; // Number of links to file
   uint64 size; // Size of file in bytes
 };
+
+// Inode table statistics, from icachestat().
+struct icachestat {
+  int size;      // entries in the table (NINODE)
+  int inuse;     // entries with references
+  uint64 hits;   // lookups that found the inode in the table
+  uint64 misses; // lookups that had to recycle an entry
+};
+
+// Lazy page fault statistics for a process, from pfstat().
+struct pfstat {
+  uint64 faults; // lazy page faults taken
+  uint64 pages;  // pages those faults mapped
+  int cluster;   // pages per fault cluster, see faultaround()
+};
+
+// Statistics for all the locks of one name, from lockstat().
+struct lockstat {
+  char name[16];
+  int sleep;        // 1 for sleep locks
+  uint64 acquires;
+  uint64 contended; // acquires that found the lock held
+  uint64 wait;      // time those spent waiting: cycles for a
+                    // spin lock, time CSR units for a sleep lock
+};
@@ -5,6 +5,7 @@
 #include "spinlock.h"
 #include "proc.h"
 #include "syscall.h"
+#include "trace.h"
 #include "defs.h"
 
 // Fetch the uint64 at addr from the current process.
@@ -109,6 +110,21 @@ extern uint64 sys_trace(void);
 extern uint64 sys_dumpvm(void);
 extern uint64 sys_map_ro(void);
 extern uint64 sys_mapzero(void);
+extern uint64 sys_spawn(void);
+extern uint64 sys_splice(void);
+extern uint64 sys_fsync(void);
+extern uint64 sys_icachestat(void);
+extern uint64 sys_nice(void);
+extern uint64 sys_nsleep(void);
+extern uint64 sys_faultaround(void);
+extern uint64 sys_pfstat(void);
+extern uint64 sys_mmap(void);
+extern uint64 sys_munmap(void);
+extern uint64 sys_traceread(void);
+extern uint64 sys_syslat(void);
+extern uint64 sys_profile(void);
+extern uint64 sys_profread(void);
+extern uint64 sys_lockstat(void);
 
 // An array mapping syscall numbers from syscall.h
 // to the function that handles the system call.
@@ -142,84 +158,60 @@ static uint64 (*syscalls[])(void) = {
 [SYS_dumpvm]  sys_dumpvm,
 [SYS_map_ro]  sys_map_ro,
 [SYS_mapzero]  sys_mapzero,
-};
-
-// EAFITos: Nombres de las syscalls para strace
-static const char *syscall_names[] = {
-[SYS_fork]    "fork",
-[SYS_exit]    "exit",
-[SYS_wait]    "wait",
-[SYS_pipe]    "pipe",
-[SYS_read]    "read",
-[SYS_kill]    "kill",
-[SYS_exec]    "exec",
-[SYS_fstat]   "fstat",
-[SYS_chdir]   "chdir",
-[SYS_dup]     "dup",
-[SYS_getpid]  "getpid",
-[SYS_sbrk]    "sbrk",
-[SYS_pause]   "pause",
-[SYS_uptime]  "uptime",
-[SYS_open]    "open",
-[SYS_write]   "write",
-[SYS_mknod]   "mknod",
-[SYS_unlink]  "unlink",
-[SYS_link]    "link",
-[SYS_mkdir]   "mkdir",
-[SYS_close]   "close",
-[SYS_rtctime] "rtctime",
-[SYS_shm_open] "shm_open",
-[SYS_shm_close] "shm_close",
-[SYS_hello]   "hello",
-[SYS_trace]   "trace",
-[SYS_dumpvm]  "dumpvm",
-[SYS_map_ro]  "map_ro",
-[SYS_mapzero] "mapzero",
+[SYS_spawn]   sys_spawn,
+[SYS_splice]  sys_splice,
+[SYS_fsync]   sys_fsync,
+[SYS_icachestat] sys_icachestat,
+[SYS_nice]    sys_nice,
+[SYS_nsleep]  sys_nsleep,
+[SYS_faultaround] sys_faultaround,
+[SYS_pfstat]  sys_pfstat,
+[SYS_mmap]    sys_mmap,
+[SYS_munmap]  sys_munmap,
+[SYS_traceread] sys_traceread,
+[SYS_syslat]  sys_syslat,
+[SYS_profile] sys_profile,
+[SYS_profread] sys_profread,
+[SYS_lockstat] sys_lockstat,
 };
 
 void
 syscall(void)
 {
-  int num;
+  int num, cpu;
+  uint64 start;
   struct proc *p = myproc();
 
   num = p->trapframe->a7;
   if(num > 0 && num < NELEM(syscalls) && syscalls[num]) {
-    // EAFITos: Argumento 0 guardado por si queremos imprimirlo luego (simplificado).
     // Use num to lookup the system call function for num, call it,
     // and store its return value in p->trapframe->a0
 
-    // EAFITos: Evaluar la máscara antes de ejecutar el handler
-    if (p->trace_mask & (1 << num)) {
-      uint64 r_a0 = p->trapframe->a0;
-      uint64 r_a1 = p->trapframe->a1;
-      uint64 r_a2 = p->trapframe->a2;
-      uint64 r_a3 = p->trapframe->a3;
-      uint64 r_a4 = p->trapframe->a4;
-      uint64 r_a5 = p->trapframe->a5;
+    // EAFITos: los ciclos de cada llamada van al histograma de
+    // latencias de trace.c, ver syslat(), si termina en el mismo
+    // hart en que empezó.
+    start = latstart(&cpu);
 
-      int arg0, arg1, arg2;
-      argint(0, &arg0);
-      argint(1, &arg1);
-      argint(2, &arg2);
-      
-      uint64 ptr0;
-      argaddr(0, &ptr0);
+    // EAFITos: si la llamada está en la máscara de trace(), se
+    // registra en el anillo de trace.c en vez de imprimirla.
+    if(p->trace_mask & (1L << num)){
+      struct traceev e;
 
-      int pid = p->pid;
-      const char *name = syscall_names[num] ? syscall_names[num] : "unknown";
-      
-      // EAFITos: Hack para no imprimir los writes() que hace el printf interno
-      // porque si traceamos write, nuestro propio printf llamará write y creará 
-      // un ciclo infinito de ruido o muchísimos prints
-      if(num != SYS_write || p->name[0] != 't' || p->name[1] != 'u' || p->name[2] != 'a') {
-        printf("%d %s: syscall %s (num=%d)\n", pid, p->name, name, num);
-        printf("  RAW (a0-a5): 0x%lx 0x%lx 0x%lx 0x%lx 0x%lx 0x%lx\n", r_a0, r_a1, r_a2, r_a3, r_a4, r_a5);
-        printf("  DECODED args: argint(0,1,2)=%d, %d, %d | argaddr(0)=0x%lx\n", arg0, arg1, arg2, ptr0);
-      }
+      e.enter = r_time();
+      e.args[0] = p->trapframe->a0;
+      e.args[1] = p->trapframe->a1;
+      e.args[2] = p->trapframe->a2;
+      e.args[3] = p->trapframe->a3;
+      e.pid = p->pid;
+      e.num = num;
+      e.ret = p->trapframe->a0 = syscalls[num]();
+      e.exit = r_time();
+      latrecord(num, cpu, start);
+      tracerecord(&e);
+      return;
     }
-
     p->trapframe->a0 = syscalls[num]();
+    latrecord(num, cpu, start);
   } else {
     printf("%d %s: unknown sys call %d\n",
             p->pid, p->name, num);
@@ -28,3 +28,18 @@
 #define SYS_dumpvm 27
 #define SYS_map_ro 28
 #define SYS_mapzero 29
+#define SYS_spawn 30
+#define SYS_splice 31
+#define SYS_fsync  32
+#define SYS_icachestat 33
+#define SYS_nice   34
+#define SYS_nsleep 35
+#define SYS_faultaround 36
+#define SYS_pfstat 37
+#define SYS_mmap 38
+#define SYS_munmap 39
+#define SYS_traceread 40
+#define SYS_syslat 41
+#define SYS_profile 42
+#define SYS_profread 43
+#define SYS_lockstat 44
@@ -8,6 +8,7 @@
 #include "riscv.h"
 #include "defs.h"
 #include "param.h"
+#include "memlayout.h"
 #include "stat.h"
 #include "spinlock.h"
 #include "proc.h"
@@ -76,6 +77,8 @@ sys_read(void)
   argint(2, &n);
   if(argfd(0, 0, &f) < 0)
     return -1;
+  if(n > 0)
+    vmaprefault(myproc(), p, n);
   return fileread(f, p, n);
 }
 
@@ -90,10 +93,40 @@ sys_write(void)
   argint(2, &n);
   if(argfd(0, 0, &f) < 0)
     return -1;
+  if(n > 0)
+    vmaprefault(myproc(), p, n);
 
   return filewrite(f, p, n);
 }
 
+// splice(fdin, fdout, n): move up to n bytes from fdin
+// to fdout inside the kernel. returns bytes moved,
+// 0 at end of file.
+uint64
+sys_splice(void)
+{
+  int n;
+  struct file *in, *out;
+
+  argint(2, &n);
+  if(argfd(0, 0, &in) < 0 || argfd(1, 0, &out) < 0)
+    return -1;
+  return filesplice(in, out, n);
+}
+
+// wait until earlier writes (to fd and everything else;
+// there is a single log) are on disk.
+uint64
+sys_fsync(void)
+{
+  struct file *f;
+
+  if(argfd(0, 0, &f) < 0)
+    return -1;
+  log_sync();
+  return 0;
+}
+
 uint64
 sys_close(void)
 {
@@ -119,6 +152,20 @@ sys_fstat(void)
   return filestat(f, st);
 }
 
+// copy inode table statistics to user struct icachestat.
+uint64
+sys_icachestat(void)
+{
+  uint64 addr;
+  struct icachestat st;
+
+  argaddr(0, &addr);
+  icachestat(&st);
+  if(copyout(myproc()->pagetable, addr, (char *)&st, sizeof(st)) < 0)
+    return -1;
+  return 0;
+}
+
 // Create the path new as a link to the same inode as old.
 uint64
 sys_link(void)
@@ -222,6 +269,7 @@ sys_unlink(void)
   memset(&de, 0, sizeof(de));
   if(writei(dp, 0, (uint64)&de, off, sizeof(de)) != sizeof(de))
     panic("unlink: writei");
+  dcache_remove(dp, name);
   if(ip->type == T_DIR){
     dp->nlink--;
     iupdate(dp);
@@ -503,3 +551,51 @@ sys_pipe(void)
   }
   return 0;
 }
+
+// map len bytes of fd at offset off, or anonymous memory if
+// flags has MAP_ANONYMOUS, into the caller's address space,
+// at addr if that is free. returns the address.
+uint64
+sys_mmap(void)
+{
+  uint64 addr, len;
+  int prot, flags, fd, off;
+  struct file *f = 0;
+  struct vma *v;
+
+  argaddr(0, &addr);
+  argaddr(1, &len);
+  argint(2, &prot);
+  argint(3, &flags);
+  argint(5, &off);
+  if(len == 0 || len > MMAPTOP || (prot & PROT_READ) == 0)
+    return -1;
+  if((flags & (MAP_SHARED|MAP_PRIVATE)) == 0 ||
+     (flags & (MAP_SHARED|MAP_PRIVATE)) == (MAP_SHARED|MAP_PRIVATE))
+    return -1;
+
+  if((flags & MAP_ANONYMOUS) == 0){
+    if(argfd(4, &fd, &f) < 0 || f->type != FD_INODE || !f->readable)
+      return -1;
+    if(off < 0 || off % PGSIZE)
+      return -1;
+    // stores must be able to reach the file.
+    if((flags & MAP_SHARED) && (prot & PROT_WRITE) && !f->writable)
+      return -1;
+  }
+
+  if((v = vmaalloc(myproc(), addr, len, prot, flags, f, off)) == 0)
+    return -1;
+  return v->start;
+}
+
+// unmap [addr, addr+len), writing modified shared file pages back.
+uint64
+sys_munmap(void)
+{
+  uint64 addr, len;
+
+  argaddr(0, &addr);
+  argaddr(1, &len);
+  return vmaunmap(myproc(), addr, len);
+}
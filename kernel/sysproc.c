@@ -6,40 +6,8 @@
 #include "spinlock.h"
 #include "proc.h"
 #include "vm.h"
-
-struct {
-  struct spinlock lock;
-  char *page;
-  int refs;
-} shmstate;
-
-void
-shm_init(void)
-{
-  initlock(&shmstate.lock, "shmstate");
-  shmstate.page = 0;
-  shmstate.refs = 0;
-}
-
-void
-shm_proc_exit(struct proc *p)
-{
-  acquire(&shmstate.lock);
-  if(p->shm_attached){
-    uvmunmap(p->pagetable, SHM_VA, 1, 0);
-    p->shm_attached = 0;
-
-    if(shmstate.refs < 1)
-      panic("shm refs");
-    shmstate.refs--;
-
-    if(shmstate.refs == 0 && shmstate.page != 0){
-      kfree(shmstate.page);
-      shmstate.page = 0;
-    }
-  }
-  release(&shmstate.lock);
-}
+#include "stat.h"
+#include "fcntl.h"
 
 uint64
 sys_exit(void)
@@ -62,6 +30,55 @@ sys_fork(void)
   return kfork();
 }
 
+// spawn(path, argv, fdmap, nfd): fork+exec in one step.
+// see kspawn() for the meaning of fdmap.
+uint64
+sys_spawn(void)
+{
+  char path[MAXPATH], *argv[MAXARG];
+  int fdmap[NOFILE], nfd, i, ret;
+  uint64 uargv, uarg, ufdmap;
+
+  argaddr(1, &uargv);
+  argaddr(2, &ufdmap);
+  argint(3, &nfd);
+  if(argstr(0, path, MAXPATH) < 0)
+    return -1;
+  if(ufdmap){
+    if(nfd < 0 || nfd > NOFILE)
+      return -1;
+    if(copyin(myproc()->pagetable, (char*)fdmap, ufdmap, nfd*sizeof(int)) < 0)
+      return -1;
+  }
+  memset(argv, 0, sizeof(argv));
+  for(i=0;; i++){
+    if(i >= NELEM(argv))
+      goto bad;
+    if(fetchaddr(uargv+sizeof(uint64)*i, (uint64*)&uarg) < 0)
+      goto bad;
+    if(uarg == 0){
+      argv[i] = 0;
+      break;
+    }
+    argv[i] = kalloc();
+    if(argv[i] == 0)
+      goto bad;
+    if(fetchstr(uarg, argv[i], PGSIZE) < 0)
+      goto bad;
+  }
+
+  ret = kspawn(path, argv, ufdmap ? fdmap : 0, nfd);
+
+  for(i = 0; i < NELEM(argv) && argv[i] != 0; i++)
+    kfree(argv[i]);
+  return ret;
+
+ bad:
+  for(i = 0; i < NELEM(argv) && argv[i] != 0; i++)
+    kfree(argv[i]);
+  return -1;
+}
+
 uint64
 sys_wait(void)
 {
@@ -88,6 +105,9 @@ sys_sbrk(void)
   } else {
     // Solo actualizamos el tamaño virtual.
     // No llamamos a growproc(n) para evitar kalloc inmediato.
+    // El heap no puede crecer sobre las regiones de mmap().
+    if(addr + n > vmalow(myproc()))
+      return -1;
     myproc()->sz += n;
   }
   
@@ -98,22 +118,22 @@ uint64
 sys_pause(void)
 {
   int n;
-  uint ticks0;
 
   argint(0, &n);
   if(n < 0)
     n = 0;
-  acquire(&tickslock);
-  ticks0 = ticks;
-  while(ticks - ticks0 < n){
-    if(killed(myproc())){
-      release(&tickslock);
-      return -1;
-    }
-    sleep(&ticks, &tickslock);
-  }
-  release(&tickslock);
-  return 0;
+  return sleepuntil(r_time() + (uint64)n * TICKTIME);
+}
+
+// nsleep(ns): sleep for ns nanoseconds, to the
+// resolution of the time CSR (100ns).
+uint64
+sys_nsleep(void)
+{
+  uint64 ns;
+
+  argaddr(0, &ns);
+  return sleepuntil(r_time() + ns / (1000000000 / TIMEFREQ));
 }
 
 uint64
@@ -125,17 +145,60 @@ sys_kill(void)
   return kkill(pid);
 }
 
+// nice(pid, n): never run pid (0 for the caller) above
+// scheduler level n. returns the old level.
+uint64
+sys_nice(void)
+{
+  int pid, n;
+
+  argint(0, &pid);
+  argint(1, &n);
+  return setnice(pid, n);
+}
+
+// set the number of pages mapped around each lazy page
+// fault; 1 maps just the faulting page. n < 0 leaves it
+// alone. returns the old value.
+uint64
+sys_faultaround(void)
+{
+  struct proc *p = myproc();
+  int n, old;
+
+  argint(0, &n);
+  if(n == 0 || n > FAULTMAX)
+    return -1;
+  old = p->faultaround;
+  if(n > 0)
+    p->faultaround = p->pf_window = n;
+  return old;
+}
+
+// copy this process's lazy page fault counters to user space.
+uint64
+sys_pfstat(void)
+{
+  struct proc *p = myproc();
+  struct pfstat st;
+  uint64 addr;
+
+  argaddr(0, &addr);
+  st.faults = p->pf_count;
+  st.pages = p->pf_pages;
+  st.cluster = p->faultaround;
+  if(copyout(p->pagetable, addr, (char *)&st, sizeof(st)) < 0)
+    return -1;
+  return 0;
+}
+
 // return how many clock tick interrupts have occurred
 // since start.
 uint64
 sys_uptime(void)
 {
-  uint xticks;
-
-  acquire(&tickslock);
-  xticks = ticks;
-  release(&tickslock);
-  return xticks;
+  // not ticks, which stands still while every CPU is idle.
+  return r_time() / TICKTIME;
 }
 
 // return seconds since Unix epoch from the Goldfish RTC
@@ -155,69 +218,73 @@ uint64
 sys_mapzero(void)
 {
   int size;
-  struct proc *p = myproc();
+  struct vma *v;
 
   argint(0, &size);
   if(size <= 0)
     return -1;
 
-  // Reserva rango virtual sin mapear físicamente:
-  // Colocamos la región justo después de sz, alineada a página.
-  uint64 start = PGROUNDUP(p->sz);
-  
-  // Guardamos la configuración de la región para usertrap()
-  p->vreg.start = start;
-  p->vreg.size = size;
-
-  // Actualizamos sz para que el kernel sepa que este rango es legal
-  p->sz = start + size;
+  // Reserva rango virtual sin mapear físicamente: una región
+  // anónima de mmap() cuyas páginas vmafault() llena con 'A'.
+  v = vmaalloc(myproc(), 0, size, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
+  if(v == 0)
+    return -1;
+  v->fill = 'A';
 
-  return start;
+  return v->start;
 }
 
+// attach the shared memory segment called name, making it
+// size bytes long if it doesn't exist yet; size 0 attaches all
+// of an existing segment. the segment goes at addr, which must
+// then be free, or wherever there is room if addr is 0.
+// returns the address.
 uint64
 sys_shm_open(void)
 {
+  char name[SHMNAME];
+  uint64 size, addr;
   struct proc *p = myproc();
+  struct shmseg *seg;
+  struct vma *v;
 
-  acquire(&shmstate.lock);
-
-  if(p->shm_attached){
-    release(&shmstate.lock);
-    return SHM_VA;
-  }
+  if(argstr(0, name, SHMNAME) < 0)
+    return -1;
+  argaddr(1, &size);
+  argaddr(2, &addr);
+  if(size > (uint64)SHMPAGES * PGSIZE || addr % PGSIZE)
+    return -1;
 
-  if(shmstate.page == 0){
-    shmstate.page = kalloc();
-    if(shmstate.page == 0){
-      release(&shmstate.lock);
-      return -1;
-    }
-    memset(shmstate.page, 0, PGSIZE);
+  if((seg = shmget(name, PGROUNDUP(size) / PGSIZE)) == 0)
+    return -1;
+  if(size == 0)
+    size = shmsize(seg);
+  v = vmaalloc(p, addr, size, PROT_READ | PROT_WRITE, MAP_SHARED, 0, 0);
+  if(v == 0){
+    shmput(seg);
+    return -1;
   }
-
-  if(mappages(p->pagetable, SHM_VA, PGSIZE, (uint64)shmstate.page,
-              PTE_U | PTE_R | PTE_W) < 0){
-    if(shmstate.refs == 0){
-      kfree(shmstate.page);
-      shmstate.page = 0;
-    }
-    release(&shmstate.lock);
+  v->seg = seg;
+  if(addr && v->start != addr){
+    vmaunmap(p, v->start, v->len);
     return -1;
   }
-
-  p->shm_attached = 1;
-  shmstate.refs++;
-
-  release(&shmstate.lock);
-  return SHM_VA;
+  return v->start;
 }
 
+// detach the shared memory segment attached at addr.
 uint64
 sys_shm_close(void)
 {
-  shm_proc_exit(myproc());
-  return 0;
+  uint64 addr;
+  struct proc *p = myproc();
+  struct vma *v;
+
+  argaddr(0, &addr);
+  if((v = vmafind(p, addr)) == 0 || v->seg == 0 || v->f || v->start != addr)
+    return -1;
+  return vmaunmap(p, v->start, v->len);
 }
 
 // EAFITos: Syscall hello
@@ -232,12 +299,84 @@ sys_hello(void)
 uint64
 sys_trace(void)
 {
-  int mask;
-  argint(0, &mask);
+  uint64 mask;
+  argaddr(0, &mask);
   myproc()->trace_mask = mask;
   return 0;
 }
 
+// copy up to n traced system calls to the user
+// array of struct traceev at addr. returns how many.
+uint64
+sys_traceread(void)
+{
+  uint64 addr;
+  int n;
+
+  argaddr(0, &addr);
+  argint(1, &n);
+  if(n < 0)
+    return -1;
+  return traceread(addr, n);
+}
+
+// copy the system call latency histograms since boot
+// to the user array at addr, see trace.h.
+uint64
+sys_syslat(void)
+{
+  uint64 addr;
+
+  argaddr(0, &addr);
+  return latread(addr);
+}
+
+// sample every CPU's pc every us microseconds, or stop
+// if us is 0, see prof.c. returns the old interval;
+// us < 0 just asks for it.
+uint64
+sys_profile(void)
+{
+  int us;
+
+  argint(0, &us);
+  if(us < 0)
+    return profset(-1);
+  if(us > 0 && us < PROFMIN)
+    return -1;
+  return profset(us);
+}
+
+// copy up to n profiler samples to the user
+// array of struct profsample at addr. returns how many.
+uint64
+sys_profread(void)
+{
+  uint64 addr;
+  int n;
+
+  argaddr(0, &addr);
+  argint(1, &n);
+  if(n < 0)
+    return -1;
+  return profread(addr, n);
+}
+
+// copy the statistics of up to n lock names to the
+// user array of struct lockstat at addr. returns how many.
+uint64
+sys_lockstat(void)
+{
+  uint64 addr;
+  int n;
+
+  argaddr(0, &addr);
+  argint(1, &n);
+  if(n < 0)
+    return -1;
+  return lockstatread(addr, n);
+}
+
 // EAFITos: syscall dumpvm
 uint64
 sys_dumpvm(void)
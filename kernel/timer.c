@@ -0,0 +1,173 @@
+// Timeouts, for pause() and nsleep().
+//
+// A process waiting for a time sleeps on &p->wakeat and sits in a
+// min-heap ordered by p->wakeat, the value of the time CSR at which
+// it should wake. Each CPU asks for its next timer interrupt at the
+// earlier of its next clock tick and the top of the heap, and a CPU
+// with nothing to run skips clock ticks until runqadd() wakes it,
+// so idle CPUs are not interrupted ten times a second for nothing.
+//
+// So a timer interrupt may come for a timeout, or, while the profiler
+// is on, to sample a busy CPU's pc (see prof.c), rather than for a
+// clock tick. c->tickat is when the next tick is due, apart from
+// those deadlines; only a tick charges the running process.
+//
+// timers.lock protects the heap and p->wakeat. It must be acquired
+// before the sleep queue and process locks.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "defs.h"
+
+struct {
+  struct spinlock lock;
+  struct proc *heap[NPROC];
+  int n;
+} timers;
+
+void
+timeoutinit(void)
+{
+  initlock(&timers.lock, "timers");
+}
+
+static void
+heapswap(int i, int j)
+{
+  struct proc *p = timers.heap[i];
+
+  timers.heap[i] = timers.heap[j];
+  timers.heap[j] = p;
+}
+
+// Restore the heap order around slot i.
+static void
+heapfix(int i)
+{
+  int c;
+
+  while(i > 0 && timers.heap[i]->wakeat < timers.heap[(i-1)/2]->wakeat){
+    heapswap(i, (i-1)/2);
+    i = (i-1)/2;
+  }
+  for(;;){
+    c = 2*i + 1;
+    if(c >= timers.n)
+      break;
+    if(c+1 < timers.n && timers.heap[c+1]->wakeat < timers.heap[c]->wakeat)
+      c++;
+    if(timers.heap[i]->wakeat <= timers.heap[c]->wakeat)
+      break;
+    heapswap(i, c);
+    i = c;
+  }
+}
+
+// Remove slot i from the heap.
+static void
+heapdel(int i)
+{
+  timers.heap[i]->wakeat = 0;
+  timers.n--;
+  if(i < timers.n){
+    timers.heap[i] = timers.heap[timers.n];
+    heapfix(i);
+  }
+}
+
+// Sleep until the time CSR reaches when.
+// Returns -1 if killed first.
+int
+sleepuntil(uint64 when)
+{
+  struct proc *p = myproc();
+  int i, r = 0;
+
+  acquire(&timers.lock);
+  p->wakeat = when;
+  timers.heap[timers.n++] = p;
+  heapfix(timers.n - 1);
+
+  // make sure this CPU's timer goes off in time; other
+  // CPUs see the new top when they re-arm.
+  if(when < r_stimecmp())
+    w_stimecmp(when);
+
+  while(r_time() < when){
+    if(killed(p)){
+      r = -1;
+      break;
+    }
+    sleep(&p->wakeat, &timers.lock);
+  }
+
+  // still in the heap if woken early, e.g. by kill().
+  if(p->wakeat){
+    for(i = 0; i < timers.n; i++){
+      if(timers.heap[i] == p){
+        heapdel(i);
+        break;
+      }
+    }
+  }
+  release(&timers.lock);
+  return r;
+}
+
+// Wake the processes whose time has come.
+// Called on each timer interrupt.
+void
+timeoutintr(void)
+{
+  struct proc *p;
+  uint64 now = r_time();
+
+  acquire(&timers.lock);
+  while(timers.n > 0 && timers.heap[0]->wakeat <= now){
+    p = timers.heap[0];
+    heapdel(0);
+    wakeup(&p->wakeat);
+  }
+  release(&timers.lock);
+}
+
+// Ask for this CPU's next timer interrupt: at the next clock
+// tick, one tick from now so the running process can be
+// preempted, or, if the CPU is idle, IDLETICKS ticks away; or at
+// the earliest timeout, if that comes first. A tick that hasn't
+// come yet, because this interrupt was for a timeout or a
+// profiler sample, is kept, and a busy CPU that is being
+// profiled takes the next sample first if it is due before
+// either. Interrupts must be off.
+void
+timerarm(int idle)
+{
+  struct cpu *c = mycpu();
+  uint64 now = r_time();
+  uint64 next, prof = __atomic_load_n(&profint, __ATOMIC_RELAXED);
+
+  if(idle)
+    c->tickat = now + IDLETICKS * TICKTIME;
+  else if(c->tickat <= now || c->tickat > now + TICKTIME)
+    c->tickat = now + TICKTIME;
+  next = c->tickat;
+  acquire(&timers.lock);
+  if(timers.n > 0 && timers.heap[0]->wakeat < next)
+    next = timers.heap[0]->wakeat;
+  release(&timers.lock);
+  if(!idle && prof && now + prof < next)
+    next = now + prof;
+  w_stimecmp(next);
+}
+
+// Is this timer interrupt a clock tick, rather than just
+// a timeout or a profiler sample? Interrupts must be off.
+int
+timertick(void)
+{
+  return r_time() >= mycpu()->tickat;
+}
@@ -0,0 +1,203 @@
+// System call tracing, for strace.
+//
+// syscall() records each call a process has asked to trace
+// (p->trace_mask, see trace()) as a struct traceev in a ring
+// belonging to the CPU the call returns on. Recording takes no
+// lock: interrupts are off while the event is written, so the CPU
+// is the ring's only writer, and it publishes the event by
+// advancing head. Readers advance tail under tracelock. A full
+// ring drops new events and counts them in lost; a reader gets
+// the count as an event with num 0 and the count in args[0].
+//
+// exit() never returns, so kexit() records it with tracexit(). strace
+// stops when it sees that event, so it is never dropped: if the ring
+// is full, the oldest event goes instead, and is counted in lost.
+//
+// Separately, syscall() counts how long every call took in a log2
+// histogram per system call number, again one set per CPU so that
+// counting needs no lock. syslat() sums them over the CPUs. Calls
+// are timed with the cycle CSR, which each hart keeps for itself,
+// so a call that slept and came back on another CPU isn't counted.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "proc.h"
+#include "trace.h"
+#include "syscall.h"
+#include "defs.h"
+
+struct tracering {
+  struct traceev ev[NTRACE];
+  uint64 head;   // next slot to write, written only by its CPU
+  uint64 tail;   // next slot to read, under tracelock
+  uint64 lost;   // events dropped because the ring was full
+};
+
+struct tracering tracering[NCPU];
+struct spinlock tracelock;
+
+uint64 lathist[NCPU][NLATSYS][NLATBUCKET];
+
+void
+traceinit(void)
+{
+  initlock(&tracelock, "trace");
+}
+
+// add e to this CPU's ring.
+void
+tracerecord(struct traceev *e)
+{
+  struct tracering *r;
+
+  push_off();
+  e->cpu = cpuid();
+  r = &tracering[e->cpu];
+  if(r->head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) < NTRACE){
+    r->ev[r->head % NTRACE] = *e;
+    __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+  } else {
+    __atomic_fetch_add(&r->lost, 1, __ATOMIC_RELAXED);
+  }
+  pop_off();
+}
+
+// record that p, which is being traced, is exiting. makes room
+// by dropping the oldest event if the ring is full, under
+// tracelock so that no reader is copying it.
+void
+tracexit(struct proc *p, int status)
+{
+  struct traceev e;
+  struct tracering *r;
+
+  memset(&e, 0, sizeof(e));
+  e.enter = e.exit = r_time();
+  e.args[0] = status;
+  e.pid = p->pid;
+  e.num = SYS_exit;
+
+  push_off();
+  r = &tracering[cpuid()];
+  acquire(&tracelock);
+  if(r->head - r->tail >= NTRACE){
+    __atomic_store_n(&r->tail, r->tail + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&r->lost, 1, __ATOMIC_RELAXED);
+  }
+  release(&tracelock);
+  tracerecord(&e);
+  pop_off();
+}
+
+// take the oldest unread event of any CPU into *e.
+// returns 0 if every ring is empty.
+static int
+tracetake(struct traceev *e)
+{
+  struct tracering *r, *best = 0;
+  struct traceev *oldest = 0;
+  uint64 lost;
+
+  for(r = tracering; r < &tracering[NCPU]; r++){
+    if((lost = __atomic_exchange_n(&r->lost, 0, __ATOMIC_RELAXED)) != 0){
+      memset(e, 0, sizeof(*e));
+      e->args[0] = lost;
+      e->cpu = r - tracering;
+      return 1;
+    }
+  }
+  for(r = tracering; r < &tracering[NCPU]; r++){
+    if(r->tail == __atomic_load_n(&r->head, __ATOMIC_ACQUIRE))
+      continue;
+    if(oldest == 0 || r->ev[r->tail % NTRACE].exit < oldest->exit){
+      best = r;
+      oldest = &r->ev[r->tail % NTRACE];
+    }
+  }
+  if(best == 0)
+    return 0;
+  *e = *oldest;
+  __atomic_store_n(&best->tail, best->tail + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+// copy up to n recorded events, oldest first, to user
+// address addr. returns how many, or -1 on a bad address.
+int
+traceread(uint64 addr, int n)
+{
+  struct traceev ev[8];
+  int i, k, total = 0;
+
+  while(total < n){
+    // copyout() may fault pages in, so not under tracelock.
+    acquire(&tracelock);
+    for(k = 0; k < NELEM(ev) && total + k < n; k++)
+      if(tracetake(&ev[k]) == 0)
+        break;
+    release(&tracelock);
+    for(i = 0; i < k; i++, total++)
+      if(copyout(myproc()->pagetable, addr + total*sizeof(ev[0]),
+                 (char*)&ev[i], sizeof(ev[0])) < 0)
+        return -1;
+    if(k < NELEM(ev))
+      break;
+  }
+  return total;
+}
+
+// the start of a system call, for latrecord(): sets *cpu to
+// this CPU and returns its cycle count, read together.
+uint64
+latstart(int *cpu)
+{
+  uint64 start;
+
+  push_off();
+  *cpu = cpuid();
+  start = r_cycle();
+  pop_off();
+  return start;
+}
+
+// count a call to system call num that latstart() saw start
+// on cpu at cycle start, unless it is ending on another CPU,
+// whose cycle count can't be compared.
+void
+latrecord(int num, int cpu, uint64 start)
+{
+  uint64 t;
+  int b = 0;
+
+  push_off();
+  if(cpuid() == cpu){
+    for(t = r_cycle() - start; t && b < NLATBUCKET-1; t >>= 1)
+      b++;
+    lathist[cpu][num][b]++;
+  }
+  pop_off();
+}
+
+// copy the histograms, summed over CPUs, to the user array of
+// NLATSYS*NLATBUCKET counts at addr.
+// returns -1 on a bad address.
+int
+latread(uint64 addr)
+{
+  uint64 sum[NLATBUCKET];
+  int c, num, b;
+
+  for(num = 0; num < NLATSYS; num++){
+    memset(sum, 0, sizeof(sum));
+    for(c = 0; c < NCPU; c++)
+      for(b = 0; b < NLATBUCKET; b++)
+        sum[b] += lathist[c][num][b];
+    if(copyout(myproc()->pagetable, addr + num*sizeof(sum),
+               (char*)sum, sizeof(sum)) < 0)
+      return -1;
+  }
+  return 0;
+}
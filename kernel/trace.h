@@ -0,0 +1,18 @@
+// A traced system call, as recorded by syscall() and
+// returned by traceread(). 64 bytes.
+struct traceev {
+  uint64 enter;    // time CSR when the call began
+  uint64 exit;     // time CSR when it returned
+  uint64 args[4];  // a0..a3 at entry
+  uint64 ret;      // return value
+  int pid;
+  short num;       // system call number
+  short cpu;       // CPU it returned on
+};
+
+// Latency histograms, as returned by syslat(): for each system
+// call number below NLATSYS, NLATBUCKET counts, where bucket 0
+// holds calls that took no cycles at all and bucket b those
+// that took [2^(b-1), 2^b) cycles.
+#define NLATSYS    64
+#define NLATBUCKET 32
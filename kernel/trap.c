@@ -20,6 +20,7 @@ void
 trapinit(void)
 {
   initlock(&tickslock, "time");
+  timeoutinit();
 }
 
 // set up to take exceptions and traps while in the kernel.
@@ -72,25 +73,19 @@ usertrap(void)
     syscall();
   } else if((which_dev = devintr()) != 0){
     // ok
+  } else if(r_scause() == 15 && cowfault(p->pagetable, r_stval()) == 0){
+    // store to a copy-on-write page, now private and writable.
   } else if(r_scause() == 13 || r_scause() == 15){
     // i. Load page fault (13) / ii. Store page fault (15)
     uint64 va = r_stval(); // Dirección virtual que falló
     
     // 1. Verifica si stval está dentro de p->sz (límites legales del proceso)
-    // 2. Si está, intentamos asignar la página físicamente
-    if(va < p->sz && vmfault(p->pagetable, va, 0) != 0){
-      // Éxito: Se asignó y mapeó la página, incrementamos el contador
-      p->pf_count++;
-      
-      // c.i. Si el fault está en la región vreg, inicializar con patrón 'A'
-      if(va >= p->vreg.start && va < p->vreg.start + p->vreg.size){
-        uint64 pa = walkaddr(p->pagetable, va);
-        if(pa != 0){
-          memset((void*)pa, 'A', PGSIZE);
-        }
-      }
-      
-      printf("page fault: pid=%d pf_count=%d stval=%p\n", p->pid, p->pf_count, (void*)va);
+    // 2. Si está, lazyfault() mapea la página y sus vecinas y
+    //    cuenta el fallo en p->pf_count (ver pfstat()).
+    if(va < p->sz && lazyfault(p, va) > 0){
+      // ok
+    } else if(va >= p->sz && vmafault(p, va, 1) != 0){
+      // ok: página de una región de mmap()
     } else {
       // 3. Si no es legal o falla kalloc/mappages, matar el proceso
       printf("page fault: pid=%d scause=%d stval=%p\n", p->pid, (int)r_scause(), (void*)va);
@@ -191,26 +186,40 @@ kerneltrap()
   w_sstatus(sstatus);
 }
 
-void
+// returns 1 if this is a clock tick, 0 if the interrupt
+// only came for a timeout or a profiler sample.
+int
 clockintr()
 {
-  if(cpuid() == 0){
-    acquire(&tickslock);
-    ticks++;
-    wakeup(&ticks);
-    release(&tickslock);
+  uint now = r_time() / TICKTIME;
+  int boost = 0, tick = timertick();
+
+  if(profint)
+    profsample();
+
+  // idle CPUs skip clock interrupts, so any CPU may be
+  // the one to notice that ticks should advance.
+  acquire(&tickslock);
+  if(now != ticks){
+    boost = now / MLFQBOOST != ticks / MLFQBOOST;
+    ticks = now;
   }
+  release(&tickslock);
+  if(boost)
+    mlfqboost();
+
+  timeoutintr();
 
   // ask for the next timer interrupt. this also clears
-  // the interrupt request. 1000000 is about a tenth
-  // of a second.
-  w_stimecmp(r_time() + 1000000);
+  // the interrupt request.
+  timerarm(0);
+  return tick;
 }
 
 // check if it's an external interrupt or software interrupt,
 // and handle it.
 // returns 2 if timer interrupt,
-// 1 if other device,
+// 1 if other device, a timeout or a profiler sample,
 // 0 if not recognized.
 int
 devintr()
@@ -240,8 +249,13 @@ devintr()
     return 1;
   } else if(scause == 0x8000000000000005L){
     // timer interrupt.
-    clockintr();
-    return 2;
+    return clockintr() ? 2 : 1;
+  } else if(scause == 0x8000000000000001L){
+    // software interrupt from another CPU, passed on by
+    // machinevec: there is work to run. scheduler() looks
+    // at the run queues once this returns.
+    w_sip(r_sip() & ~2);
+    return 1;
   } else {
     return 0;
   }
@@ -212,26 +212,19 @@ alloc3_desc(int *idx)
   return 0;
 }
 
-void
-virtio_disk_rw(struct buf *b, int write)
+// format a request for b in three free descriptors
+// and put it on the avail ring; the device isn't told
+// until the caller writes QUEUE_NOTIFY.
+// caller must hold vdisk_lock.
+static void
+virtio_disk_queue(struct buf *b, int write, int *idx)
 {
   uint64 sector = b->blockno * (BSIZE / 512);
 
-  acquire(&disk.vdisk_lock);
-
   // the spec's Section 5.2 says that legacy block operations use
   // three descriptors: one for type/reserved/sector, one for the
   // data, one for a 1-byte status result.
 
-  // allocate the three descriptors.
-  int idx[3];
-  while(1){
-    if(alloc3_desc(idx) == 0) {
-      break;
-    }
-    sleep(&disk.free[0], &disk.vdisk_lock);
-  }
-
   // format the three descriptors.
   // qemu's virtio-blk.c reads them.
 
@@ -277,20 +270,70 @@ virtio_disk_rw(struct buf *b, int write)
   disk.avail->idx += 1; // not % NUM ...
 
   __sync_synchronize();
+}
 
-  *R(VIRTIO_MMIO_QUEUE_NOTIFY) = 0; // value is queue number
+// queue requests for n bufs and tell the device,
+// with one notify per batch rather than per buf.
+// caller must hold vdisk_lock.
+static void
+virtio_disk_start(struct buf **bufs, int n, int write)
+{
+  int i, queued = 0;
+  int idx[3];
 
-  // Wait for virtio_disk_intr() to say request has finished.
-  while(b->disk == 1) {
-    sleep(b, &disk.vdisk_lock);
+  for(i = 0; i < n; i++){
+    while(alloc3_desc(idx) != 0){
+      // out of descriptors: start what we have so far
+      // and wait for completions to free some.
+      if(queued){
+        *R(VIRTIO_MMIO_QUEUE_NOTIFY) = 0; // value is queue number
+        queued = 0;
+      }
+      sleep(&disk.free[0], &disk.vdisk_lock);
+    }
+    virtio_disk_queue(bufs[i], write, idx);
+    queued++;
   }
+  if(queued)
+    *R(VIRTIO_MMIO_QUEUE_NOTIFY) = 0; // value is queue number
+}
 
-  disk.info[idx[0]].b = 0;
-  free_chain(idx[0]);
+// read or write n bufs, keeping as many requests in
+// flight as there are descriptors. returns once all
+// are done.
+void
+virtio_disk_rw_many(struct buf **bufs, int n, int write)
+{
+  acquire(&disk.vdisk_lock);
+
+  virtio_disk_start(bufs, n, write);
 
+  // Wait for virtio_disk_intr() to say the requests have finished.
+  for(int i = 0; i < n; i++){
+    while(bufs[i]->disk == 1)
+      sleep(bufs[i], &disk.vdisk_lock);
+  }
+
+  release(&disk.vdisk_lock);
+}
+
+// start reading n bufs (marked b->async) and return
+// without waiting; virtio_disk_intr() hands each one
+// to bdone() when it arrives.
+void
+virtio_disk_readahead(struct buf **bufs, int n)
+{
+  acquire(&disk.vdisk_lock);
+  virtio_disk_start(bufs, n, 0);
   release(&disk.vdisk_lock);
 }
 
+void
+virtio_disk_rw(struct buf *b, int write)
+{
+  virtio_disk_rw_many(&b, 1, write);
+}
+
 void
 virtio_disk_intr()
 {
@@ -318,7 +361,18 @@ virtio_disk_intr()
 
     struct buf *b = disk.info[id].b;
     b->disk = 0;   // disk is done with buf
-    wakeup(b);
+
+    // free the chain here rather than in the waiter, so
+    // descriptors come back as soon as the device is done.
+    disk.info[id].b = 0;
+    free_chain(id);
+
+    if(b->async){
+      b->async = 0;
+      bdone(b);    // read-ahead: no one is waiting
+    } else {
+      wakeup(b);
+    }
 
     disk.used_idx += 1;
   }
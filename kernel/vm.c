@@ -36,6 +36,9 @@ _vmprint(pagetable_t pagetable, int level)
         if(pte & PTE_W) printf("W"); else printf("-");
         if(pte & PTE_X) printf("X"); else printf("-");
         if(pte & PTE_U) printf("U"); else printf("-");
+        // a leaf above the last level maps a bigger page.
+        if(level == 1) printf(" 2M");
+        else if(level == 0) printf(" 1G");
         printf("\n");
       }
     }
@@ -63,6 +66,9 @@ kvmmake(void)
 
   kvmmap(kpgtbl, RTC0, RTC0, PGSIZE, PTE_R | PTE_W);
 
+  // CLINT software interrupt registers, for cpuwake().
+  kvmmap(kpgtbl, CLINT, CLINT, PGSIZE, PTE_R | PTE_W);
+
   kvmmap(kpgtbl, PLIC, PLIC, 0x4000000, PTE_R | PTE_W);
 
   kvmmap(kpgtbl, KERNBASE, KERNBASE, (uint64)etext-KERNBASE, PTE_R | PTE_X);
@@ -99,9 +105,9 @@ kvminithart()
   sfence_vma();
 }
 
-// Return the address of the PTE in page table pagetable
-// that corresponds to virtual address va.  If alloc!=0,
-// create any required page-table pages.
+// Return the address of the level-leaf PTE in page table
+// pagetable that corresponds to virtual address va.  If
+// alloc!=0, create any required page-table pages.
 //
 // The risc-v Sv39 scheme has three levels of page-table
 // pages. A page-table page contains 512 64-bit PTEs.
@@ -111,15 +117,21 @@ kvminithart()
 //   21..29 -- 9 bits of level-1 index.
 //   12..20 -- 9 bits of level-0 index.
 //    0..11 -- 12 bits of byte offset within the page.
-pte_t *
-walk(pagetable_t pagetable, uint64 va, int alloc)
+//
+// A level-1 PTE may instead be a leaf mapping a whole
+// 2-megabyte megapage, marked PTE_MEGA; the walk stops
+// there and returns that PTE for any va inside it.
+static pte_t *
+walklevel(pagetable_t pagetable, uint64 va, int alloc, int leaf)
 {
   if(va >= MAXVA)
     panic("walk");
 
-  for(int level = 2; level > 0; level--) {
+  for(int level = 2; level > leaf; level--) {
     pte_t *pte = &pagetable[PX(level, va)];
     if(*pte & PTE_V) {
+      if(*pte & PTE_MEGA)
+        return pte;
       pagetable = (pagetable_t)PTE2PA(*pte);
     } else {
       if(!alloc || (pagetable = (pde_t*)kalloc()) == 0)
@@ -128,7 +140,15 @@ walk(pagetable_t pagetable, uint64 va, int alloc)
       *pte = PA2PTE(pagetable) | PTE_V;
     }
   }
-  return &pagetable[PX(0, va)];
+  return &pagetable[PX(leaf, va)];
+}
+
+// Return the address of the PTE that maps va: a level-0
+// PTE, or a level-1 PTE if va is in a megapage.
+pte_t *
+walk(pagetable_t pagetable, uint64 va, int alloc)
+{
+  return walklevel(pagetable, va, alloc, 0);
 }
 
 // Look up a virtual address, return the physical address,
@@ -151,18 +171,22 @@ walkaddr(pagetable_t pagetable, uint64 va)
   if((*pte & PTE_U) == 0)
     return 0;
   pa = PTE2PA(*pte);
+  if(*pte & PTE_MEGA)
+    pa += PGROUNDDOWN(va) % MEGASIZE;
   return pa;
 }
 
 // Create PTEs for virtual addresses starting at va that refer to
 // physical addresses starting at pa.
 // va and size MUST be page-aligned.
+// Where va and pa are both megapage-aligned and at least a
+// megapage remains, maps a megapage with a single level-1 PTE.
 // Returns 0 on success, -1 if walk() couldn't
 // allocate a needed page-table page.
 int
 mappages(pagetable_t pagetable, uint64 va, uint64 size, uint64 pa, int perm)
 {
-  uint64 a, last;
+  uint64 a, end, sz;
   pte_t *pte;
 
   if((va % PGSIZE) != 0)
@@ -174,22 +198,48 @@ mappages(pagetable_t pagetable, uint64 va, uint64 size, uint64 pa, int perm)
   if(size == 0)
     panic("mappages: size");
   
-  a = va;
-  last = va + size - PGSIZE;
-  for(;;){
-    if((pte = walk(pagetable, a, 1)) == 0)
+  end = va + size;
+  for(a = va; a < end; a += sz, pa += sz){
+    if(a % MEGASIZE == 0 && pa % MEGASIZE == 0 && end - a >= MEGASIZE){
+      sz = MEGASIZE;
+      pte = walklevel(pagetable, a, 1, 1);
+    } else {
+      sz = PGSIZE;
+      pte = walk(pagetable, a, 1);
+    }
+    if(pte == 0)
       return -1;
     if(*pte & PTE_V)
       panic("mappages: remap");
-    *pte = PA2PTE(pa) | perm | PTE_V;
-    if(a == last)
-      break;
-    a += PGSIZE;
-    pa += PGSIZE;
+    *pte = PA2PTE(pa) | perm | PTE_V | (sz == MEGASIZE ? PTE_MEGA : 0);
   }
   return 0;
 }
 
+// Replace the megapage mapping va, if any, with a level-0
+// page table of 4096-byte PTEs for the same memory, so that
+// part of it can be unmapped or shared.
+// Returns 0 on success, -1 if out of memory.
+int
+uvmdemote(pagetable_t pagetable, uint64 va)
+{
+  pte_t *pte;
+  pagetable_t pt;
+  uint64 pa;
+  int i;
+
+  if((pte = walk(pagetable, va, 0)) == 0 || (*pte & PTE_MEGA) == 0)
+    return 0;
+  if((pt = (pagetable_t)kalloc()) == 0)
+    return -1;
+  pa = PTE2PA(*pte);
+  for(i = 0; i < 512; i++)
+    pt[i] = PA2PTE(pa + i*PGSIZE) | (PTE_FLAGS(*pte) & ~PTE_MEGA);
+  *pte = PA2PTE(pt) | PTE_V;
+  sfence_vma();
+  return 0;
+}
+
 // create an empty user page table.
 // returns 0 if out of memory.
 pagetable_t
@@ -220,6 +270,18 @@ uvmunmap(pagetable_t pagetable, uint64 va, uint64 npages, int do_free)
       continue;   
     if((*pte & PTE_V) == 0)  // has physical page been allocated?
       continue;
+    if(*pte & PTE_MEGA){
+      // callers uvmdemote() a megapage they unmap only part of.
+      if(a % MEGASIZE != 0 || a + MEGASIZE > va + npages*PGSIZE)
+        panic("uvmunmap: part of megapage");
+      if(do_free){
+        for(uint64 pa = PTE2PA(*pte); pa < PTE2PA(*pte) + MEGASIZE; pa += PGSIZE)
+          kfree((void*)pa);
+      }
+      *pte = 0;
+      a += MEGASIZE - PGSIZE;
+      continue;
+    }
     if(do_free){
       uint64 pa = PTE2PA(*pte);
       kfree((void*)pa);
@@ -304,39 +366,54 @@ uvmfree(pagetable_t pagetable, uint64 sz)
   freewalk(pagetable);
 }
 
-// Given a parent process's page table, copy
-// its memory into a child's page table.
-// Copies both the page table and the
-// physical memory.
+// Given a parent process's page table, share
+// its memory with a child's page table.
+// Copies only the page table: writable pages become
+// read-only copy-on-write in both parent and child,
+// and cowfault() copies a page on the first store.
 // returns 0 on success, -1 on failure.
 // frees any allocated pages on failure.
 int
 uvmcopy(pagetable_t old, pagetable_t new, uint64 sz)
+{
+  return uvmshare(old, new, 0, PGROUNDUP(sz), 1);
+}
+
+// map the pages of old in [start, end) into new as well,
+// copy-on-write if cow is set, otherwise writable by both.
+// megapages of old are demoted first, so that copy-on-write
+// works a 4096-byte page at a time.
+// returns 0 on success, -1 on failure.
+// frees any allocated pages on failure.
+int
+uvmshare(pagetable_t old, pagetable_t new, uint64 start, uint64 end, int cow)
 {
   pte_t *pte;
   uint64 pa, i;
   uint flags;
-  char *mem;
 
-  for(i = 0; i < sz; i += PGSIZE){
+  for(i = start; i < end; i += PGSIZE){
     if((pte = walk(old, i, 0)) == 0)
       continue;   // page table entry hasn't been allocated
     if((*pte & PTE_V) == 0)
       continue;   // physical page hasn't been allocated
+    if(*pte & PTE_MEGA){
+      if(uvmdemote(old, i) < 0)
+        goto err;
+      pte = walk(old, i, 0);
+    }
+    if(cow && (*pte & PTE_W))
+      *pte = (*pte & ~PTE_W) | PTE_COW;
     pa = PTE2PA(*pte);
     flags = PTE_FLAGS(*pte);
-    if((mem = kalloc()) == 0)
-      goto err;
-    memmove(mem, (char*)pa, PGSIZE);
-    if(mappages(new, i, PGSIZE, (uint64)mem, flags) != 0){
-      kfree(mem);
+    if(mappages(new, i, PGSIZE, pa, flags) != 0)
       goto err;
-    }
+    krefinc((void*)pa);
   }
   return 0;
 
  err:
-  uvmunmap(new, 0, i / PGSIZE, 1);
+  uvmunmap(new, start, (i - start) / PGSIZE, 1);
   return -1;
 }
 
@@ -375,6 +452,12 @@ copyout(pagetable_t pagetable, uint64 dstva, char *src, uint64 len)
     }
 
     pte = walk(pagetable, va0, 0);
+    // break copy-on-write sharing before the kernel stores.
+    if(*pte & PTE_COW){
+      if(cowfault(pagetable, va0) < 0)
+        return -1;
+      pa0 = PTE2PA(*pte);
+    }
     // forbid copyout over read-only user text pages.
     if((*pte & PTE_W) == 0)
       return -1;
@@ -463,7 +546,8 @@ copyinstr(pagetable_t pagetable, char *dst, uint64 srcva, uint64 max)
 }
 
 // allocate and map user memory if process is referencing a page
-// that was lazily allocated in sys_sbrk().
+// that was lazily allocated in sys_sbrk() or mmap(). pages of
+// a file mapping are left to vmaprefault(), see vma.c.
 // returns 0 if va is invalid or already mapped, or if
 // out of physical memory, and physical address if successful.
 uint64
@@ -473,7 +557,7 @@ vmfault(pagetable_t pagetable, uint64 va, int read)
   struct proc *p = myproc();
 
   if (va >= p->sz)
-    return 0;
+    return vmafault(p, va, 0);
   va = PGROUNDDOWN(va);
   if(ismapped(pagetable, va)) {
     return 0;
@@ -489,6 +573,125 @@ vmfault(pagetable_t pagetable, uint64 va, int read)
   return mem;
 }
 
+// map the megapage-aligned block of heap holding va with a
+// single megapage, if all of it is below p->sz, none of it
+// is mapped yet, and the megapage pool isn't empty.
+// returns 1 if it did.
+static int
+megafault(struct proc *p, uint64 va)
+{
+  uint64 a = va - va % MEGASIZE;
+  pte_t *pte;
+  char *mem;
+  int i;
+
+  if(a + MEGASIZE > p->sz)
+    return 0;
+  if((pte = walklevel(p->pagetable, a, 0, 1)) != 0 && (*pte & PTE_V))
+    return 0;
+  if((mem = megaalloc()) == 0)
+    return 0;
+  memset(mem, 0, MEGASIZE);
+  if(mappages(p->pagetable, a, MEGASIZE, (uint64)mem, PTE_W|PTE_U|PTE_R) != 0){
+    for(i = 0; i < MEGASIZE / PGSIZE; i++)
+      kfree(mem + i*PGSIZE);
+    return 0;
+  }
+  p->pf_count++;
+  p->pf_pages += MEGASIZE / PGSIZE;
+  return 1;
+}
+
+// handle a page fault at va, a lazily-allocated user address:
+// map the faulting page and, to save a trap per page, the
+// unmapped pages around it. The cluster is the aligned group of
+// p->faultaround pages holding va, so random access still maps
+// its neighbors; a fault right past the previous cluster looks
+// sequential, so the cluster starts at va instead and doubles,
+// up to FAULTMAX pages, like file read-ahead. A fault in a
+// megapage-sized block of fresh heap maps all of it with one
+// megapage instead. A p->faultaround of 1 maps one page per
+// fault, as plain lazy allocation does.
+// returns the number of pages mapped, 0 if va isn't a lazy
+// address or if out of physical memory.
+int
+lazyfault(struct proc *p, uint64 va)
+{
+  uint64 a, start, end;
+  int n;
+
+  va = PGROUNDDOWN(va);
+  if(p->faultaround > 1 && megafault(p, va))
+    return MEGASIZE / PGSIZE;
+  if(vmfault(p->pagetable, va, 0) == 0)
+    return 0;
+
+  if(va == p->pf_next && p->faultaround > 1){
+    p->pf_window *= 2;
+    if(p->pf_window > FAULTMAX)
+      p->pf_window = FAULTMAX;
+    start = va;
+  } else {
+    p->pf_window = p->faultaround;
+    start = va - va % ((uint64)p->pf_window * PGSIZE);
+  }
+  end = start + (uint64)p->pf_window * PGSIZE;
+  if(end > PGROUNDUP(p->sz))
+    end = PGROUNDUP(p->sz);
+
+  n = 1;
+  for(a = start; a < end; a += PGSIZE){
+    if(a == va || ismapped(p->pagetable, a))
+      continue;
+    // the rest is only a guess; stop if memory is short.
+    if(vmfault(p->pagetable, a, 0) == 0)
+      break;
+    n++;
+  }
+  p->pf_next = end;
+  p->pf_count++;
+  p->pf_pages += n;
+  return n;
+}
+
+// handle a store to a copy-on-write page: give the
+// faulting page table a private, writable copy, or just
+// make the page writable if no one else refers to it.
+// returns 0 on success, -1 if va isn't a copy-on-write
+// user page or if out of physical memory.
+int
+cowfault(pagetable_t pagetable, uint64 va)
+{
+  pte_t *pte;
+  uint64 pa;
+  uint flags;
+  char *mem;
+
+  if(va >= MAXVA)
+    return -1;
+  va = PGROUNDDOWN(va);
+  if((pte = walk(pagetable, va, 0)) == 0)
+    return -1;
+  if((*pte & PTE_V) == 0 || (*pte & PTE_U) == 0 || (*pte & PTE_COW) == 0)
+    return -1;
+
+  pa = PTE2PA(*pte);
+  flags = (PTE_FLAGS(*pte) | PTE_W) & ~PTE_COW;
+
+  // last reference: nobody else can see the page any more.
+  if(krefcnt((void*)pa) == 1){
+    *pte = PA2PTE(pa) | flags;
+    return 0;
+  }
+
+  if((mem = kalloc()) == 0)
+    return -1;
+  memmove(mem, (char*)pa, PGSIZE);
+  *pte = PA2PTE(mem) | flags;
+  kfree((void*)pa);
+  return 0;
+}
+
 int
 ismapped(pagetable_t pagetable, uint64 va)
 {
@@ -0,0 +1,395 @@
+// Memory-mapped regions, for mmap() and munmap().
+//
+// Each process has a small table of VMAs, p->vma[], describing the
+// regions it has mapped above its heap. The regions are placed
+// top-down from MMAPTOP, and the heap may not grow into them.
+// Pages are allocated on first touch, by vmafault(): anonymous pages
+// start out zeroed, and file pages are read through the buffer
+// cache. Reading a file page sleeps on the inode lock, which
+// copyin() and copyout() must not do, since their callers may hold
+// a spinlock (pipes, the console) or another inode's lock; so file
+// pages are only faulted in from usertrap(), or ahead of time by
+// read() and write() with vmaprefault(). Regions attached to a
+// shared memory segment by shm_open() take their pages from the
+// segment instead, see shm.c, and so do MAP_SHARED file mappings,
+// from the file's own segment: every process mapping the file
+// shares one physical page per file page, read in by whichever
+// touches it first. Modified pages of a MAP_SHARED file mapping
+// are written back to the file when they are unmapped.
+//
+// fork() copies the table; MAP_PRIVATE pages become copy-on-write,
+// while MAP_SHARED pages stay shared between parent and child.
+//
+// The table is private to its process, so no lock is needed.
+
+#include "types.h"
+#include "param.h"
+#include "memlayout.h"
+#include "riscv.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "proc.h"
+#include "fs.h"
+#include "file.h"
+#include "fcntl.h"
+#include "defs.h"
+
+// the region holding va, or 0.
+struct vma*
+vmafind(struct proc *p, uint64 va)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->len && va >= v->start && va < v->start + v->len)
+      return v;
+  return 0;
+}
+
+// the lowest mapped address, or MMAPTOP;
+// the heap must stay below it.
+uint64
+vmalow(struct proc *p)
+{
+  struct vma *v;
+  uint64 low = MMAPTOP;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->len && v->start < low)
+      low = v->start;
+  return low;
+}
+
+// does [va, va+len) overlap a region of p?
+static int
+vmaoverlap(struct proc *p, uint64 va, uint64 len)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->len && va < v->start + v->len && v->start < va + len)
+      return 1;
+  return 0;
+}
+
+// find room for len bytes: at addr if that is free,
+// otherwise in the highest gap below MMAPTOP.
+// returns 0 if there is no room.
+static uint64
+vmaplace(struct proc *p, uint64 addr, uint64 len)
+{
+  uint64 a, heap = PGROUNDUP(p->sz);
+  struct vma *v;
+
+  if(addr && addr % PGSIZE == 0 && addr >= heap &&
+     addr + len > addr && addr + len <= MMAPTOP && !vmaoverlap(p, addr, len))
+    return addr;
+
+  a = MMAPTOP;
+  for(;;){
+    if(len > a || a - len < heap)
+      return 0;
+    for(v = p->vma; v < &p->vma[NVMA]; v++)
+      if(v->len && v->start < a && a - len < v->start + v->len)
+        break;
+    if(v == &p->vma[NVMA])
+      return a - len;
+    a = v->start;
+  }
+}
+
+// make a new region of len bytes for p, near addr if it is
+// not 0. takes a new reference to f, if any, and to f's
+// segment for a shared mapping of it.
+// returns the region, or 0 if out of slots, address space or
+// segments, or if a shared mapping reaches past the largest
+// possible file.
+struct vma*
+vmaalloc(struct proc *p, uint64 addr, uint64 len, int prot, int flags,
+         struct file *f, uint off)
+{
+  struct vma *v;
+  struct shmseg *seg = 0;
+  uint64 start;
+
+  len = PGROUNDUP(len);
+  if(len == 0 || (start = vmaplace(p, addr, len)) == 0)
+    return 0;
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    if(v->len == 0){
+      if(f && (flags & MAP_SHARED)){
+        if(off + len > (uint64)MAXFILE * BSIZE || (seg = shmfile(f->ip)) == 0)
+          return 0;
+      }
+      v->start = start;
+      v->len = len;
+      v->prot = prot;
+      v->flags = flags;
+      v->f = f ? filedup(f) : 0;
+      v->seg = seg;
+      v->off = off;
+      v->fill = 0;
+      return v;
+    }
+  }
+  return 0;
+}
+
+// map the page of v at va, which isn't mapped yet.
+// returns the physical address, or 0 if out of memory.
+static uint64
+vmapage(struct proc *p, struct vma *v, uint64 va)
+{
+  struct inode *ip;
+  uint off = v->off + (va - v->start);
+  char *mem;
+  int perm, fresh;
+
+  if(v->seg && v->f){
+    // read the page in only when the file's segment gets it,
+    // holding the inode lock so other mappings wait for that.
+    ip = v->f->ip;
+    ilock(ip);
+    mem = (char*)shmpage(v->seg, off / PGSIZE, &fresh);
+    if(mem && fresh)
+      readi(ip, 0, (uint64)mem, off, PGSIZE);
+    iunlock(ip);
+    if(mem == 0)
+      return 0;
+  } else if(v->seg){
+    if((mem = (char*)shmpage(v->seg, off / PGSIZE, 0)) == 0)
+      return 0;
+  } else if((mem = kalloc()) == 0){
+    return 0;
+  } else {
+    // for a file, readi() leaves the part past its end zeroed.
+    memset(mem, v->fill, PGSIZE);
+    if(v->f){
+      ip = v->f->ip;
+      ilock(ip);
+      readi(ip, 0, (uint64)mem, off, PGSIZE);
+      iunlock(ip);
+    }
+  }
+
+  perm = PTE_U;
+  if(v->prot & PROT_READ)
+    perm |= PTE_R;
+  if(v->prot & PROT_WRITE)
+    perm |= PTE_W;
+  if(v->prot & PROT_EXEC)
+    perm |= PTE_X;
+  if(mappages(p->pagetable, va, PGSIZE, (uint64)mem, perm) != 0){
+    kfree(mem);
+    return 0;
+  }
+  return (uint64)mem;
+}
+
+// handle a fault at va in one of p's regions: map the page
+// and, as lazyfault() does for the heap, up to p->faultaround
+// pages after it in the same region. a file page is only read
+// in if io is set, i.e. if the caller holds no locks.
+// returns the physical address for va, or 0 if va isn't in a
+// region, is already mapped, is a file page and io isn't set,
+// or if out of memory.
+uint64
+vmafault(struct proc *p, uint64 va, int io)
+{
+  struct vma *v;
+  uint64 a, end, pa;
+
+  if((v = vmafind(p, va)) == 0 || (v->f && !io))
+    return 0;
+  va = PGROUNDDOWN(va);
+  if(ismapped(p->pagetable, va))
+    return 0;
+  if((pa = vmapage(p, v, va)) == 0)
+    return 0;
+
+  end = va + (uint64)p->faultaround * PGSIZE;
+  if(end > v->start + v->len)
+    end = v->start + v->len;
+  for(a = va + PGSIZE; a < end; a += PGSIZE){
+    if(ismapped(p->pagetable, a))
+      continue;
+    if(vmapage(p, v, a) == 0)
+      break;
+  }
+  return pa;
+}
+
+// read in the unmapped file pages of [va, va+len), so that a
+// system call can copy to or from them with copyin() and
+// copyout(). called with no locks held.
+void
+vmaprefault(struct proc *p, uint64 va, uint64 len)
+{
+  struct vma *v;
+  uint64 a;
+
+  if(va + len < va)
+    return;
+  for(a = PGROUNDDOWN(va); a < va + len; a += PGSIZE){
+    if((v = vmafind(p, a)) == 0 || v->f == 0 || ismapped(p->pagetable, a))
+      continue;
+    if(vmafault(p, a, 1) == 0)
+      break;
+  }
+}
+
+// write the page of v at va, held at pa, back to v's file.
+// a mapping never grows its file.
+static void
+vmawrite(struct vma *v, uint64 va, uint64 pa)
+{
+  struct inode *ip = v->f->ip;
+  uint off = v->off + (va - v->start);
+  // as in filewrite(), a few blocks per transaction.
+  int max = ((MAXOPBLOCKS-1-1-2) / 2) * BSIZE;
+  int i, n;
+
+  for(i = 0; i < PGSIZE; i += n){
+    n = PGSIZE - i;
+    if(n > max)
+      n = max;
+    begin_op();
+    ilock(ip);
+    if(off + i >= ip->size)
+      n = 0;
+    else if(off + i + n > ip->size)
+      n = ip->size - (off + i);
+    if(n > 0)
+      writei(ip, 0, pa + i, off + i, n);
+    iunlock(ip);
+    end_op();
+    if(n <= 0)
+      break;
+  }
+}
+
+// unmap v's pages in [va, end), writing modified pages of a
+// shared file mapping back first.
+static void
+vmaunmappages(struct proc *p, struct vma *v, uint64 va, uint64 end)
+{
+  uint64 a, pa;
+  pte_t *pte;
+
+  for(a = va; a < end; a += PGSIZE){
+    if((pte = walk(p->pagetable, a, 0)) == 0 || (*pte & PTE_V) == 0)
+      continue;
+    pa = PTE2PA(*pte);
+    if(v->f && (v->flags & MAP_SHARED) && (*pte & PTE_D))
+      vmawrite(v, a, pa);
+    *pte = 0;
+    kfree((void*)pa);
+  }
+}
+
+// unmap [va, va+len) from p. the range may cover parts of
+// several regions; a region with a hole punched in its middle
+// is split in two. returns -1 if that needs a free slot and
+// there isn't one.
+int
+vmaunmap(struct proc *p, uint64 va, uint64 len)
+{
+  struct vma *v, *nv;
+  uint64 s, e, end;
+
+  if(va % PGSIZE || len == 0 || va + len < va)
+    return -1;
+  end = PGROUNDUP(va + len);
+
+  // find a slot first for the one region that may need splitting.
+  nv = 0;
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    if(v->len && va > v->start && end < v->start + v->len){
+      for(nv = p->vma; nv < &p->vma[NVMA]; nv++)
+        if(nv->len == 0)
+          break;
+      if(nv == &p->vma[NVMA])
+        return -1;
+      *nv = *v;
+      nv->start = end;
+      nv->len = v->start + v->len - end;
+      nv->off = v->off + (end - v->start);
+      if(nv->f)
+        filedup(nv->f);
+      if(nv->seg)
+        shmdup(nv->seg);
+      v->len = end - v->start;
+      break;
+    }
+  }
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    if(v->len == 0 || end <= v->start || v->start + v->len <= va)
+      continue;
+    s = va > v->start ? va : v->start;
+    e = end < v->start + v->len ? end : v->start + v->len;
+    vmaunmappages(p, v, s, e);
+    if(s == v->start && e == v->start + v->len){
+      if(v->f)
+        fileclose(v->f);
+      if(v->seg)
+        shmput(v->seg);
+      v->f = 0;
+      v->seg = 0;
+      v->len = 0;
+    } else if(s == v->start){
+      v->off += e - s;
+      v->start = e;
+      v->len -= e - s;
+    } else {
+      v->len = s - v->start;
+    }
+  }
+  return 0;
+}
+
+// unmap all of p's regions, for exit() and exec().
+void
+vmaexit(struct proc *p)
+{
+  struct vma *v;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++)
+    if(v->len)
+      vmaunmap(p, v->start, v->len);
+}
+
+// give child np copies of p's regions, for fork().
+// the pages themselves are shared: copy-on-write for private
+// regions, writable by both for shared ones.
+// returns 0 on success, -1 if out of memory, in which case
+// np is left without any regions.
+int
+vmacopy(struct proc *p, struct proc *np)
+{
+  struct vma *v, *w;
+
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    if(v->len == 0)
+      continue;
+    if(uvmshare(p->pagetable, np->pagetable, v->start, v->start + v->len,
+                (v->flags & MAP_PRIVATE) != 0) < 0){
+      // undo the regions already shared.
+      for(w = p->vma; w < v; w++)
+        if(w->len)
+          uvmunmap(np->pagetable, w->start, w->len / PGSIZE, 1);
+      return -1;
+    }
+  }
+
+  // no file can be closed here, so duplicate only once the
+  // pages have all been shared.
+  for(v = p->vma; v < &p->vma[NVMA]; v++){
+    np->vma[v - p->vma] = *v;
+    if(v->len && v->f)
+      filedup(v->f);
+    if(v->len && v->seg)
+      shmdup(v->seg);
+  }
+  return 0;
+}
@@ -14,6 +14,7 @@
 #define MAXARGS    10
 #define LINE_MAX   1024
 #define BUF_SIZE   512
+#define SPLICE_CHUNK (64*1024)  // bytes por llamada a splice()
 
 // Tipos de comandos que entiende la shell
 #define EXEC  1
@@ -86,8 +87,11 @@ int fork1(void);
 void panic(char*);
 struct cmd *parsecmd(char*);
 void runcmd(struct cmd*) __attribute__((noreturn));
+int spawnsimple(char*);
+int spawnexec(struct cmd*, int, int);
 
 // Funciones del parser
+int gettoken(char**, char*, char**, char**);
 struct cmd *parseline(char**, char*);
 struct cmd *parsepipe(char**, char*);
 struct cmd *parseexec(char**, char*);
@@ -412,11 +416,9 @@ builtin_leer(char **argv, int argc)
     return 1;
   }
 
-  char buf[BUF_SIZE];
-  int n;
-  while ((n = read(fd, buf, sizeof(buf))) > 0) {
-    write(1, buf, n);
-  }
+  // splice pasa los datos a la consola sin copiarlos a la shell
+  while (splice(fd, 1, SPLICE_CHUNK) > 0)
+    ;
 
   close(fd);
   return 0;
@@ -647,16 +649,19 @@ builtin_copiar(char **argv, int argc)
     return 1;
   }
 
-  char buf[BUF_SIZE];
-  int n;
-  while ((n = read(src_fd, buf, sizeof(buf))) > 0) {
-    if (write(dst_fd, buf, n) != n) {
-      fprintf(2, "copiar: write error\n");
-      close(src_fd);
-      close(dst_fd);
-      unlink(argv[2]);
-      return 1;
-    }
+  // splice copia dentro del kernel, sin pasar por un buffer de la shell
+  int n, total = 0;
+  if (fstat(src_fd, &st) < 0)
+    st.size = 0;
+  while ((n = splice(src_fd, dst_fd, SPLICE_CHUNK)) > 0)
+    total += n;
+  // una copia incompleta (p. ej. disco lleno) también es un error
+  if (n < 0 || total != st.size) {
+    fprintf(2, "copiar: write error\n");
+    close(src_fd);
+    close(dst_fd);
+    unlink(argv[2]);
+    return 1;
   }
 
   close(src_fd);
@@ -994,7 +999,8 @@ runcmd(struct cmd *cmd)
     if(pipe(p) < 0)
       panic("pipe");
     // Lado izquierdo: manda la salida al tubo
-    if(fork1() == 0){
+    // (si es un programa simple se lanza con spawn, sin fork)
+    if(spawnexec(pcmd->left, 0, p[1]) < 0 && fork1() == 0){
       close(1);
       dup(p[1]);
       close(p[0]);
@@ -1002,7 +1008,7 @@ runcmd(struct cmd *cmd)
       runcmd(pcmd->left);
     }
     // Lado derecho: recibe la entrada desde el tubo
-    if(fork1() == 0){
+    if(spawnexec(pcmd->right, p[0], 1) < 0 && fork1() == 0){
       close(0);
       dup(p[0]);
       close(p[0]);
@@ -1025,6 +1031,97 @@ runcmd(struct cmd *cmd)
   exit(0);
 }
 
+// Lanza un comando EXEC con spawn(), con la entrada y salida dadas.
+// Devuelve el pid del hijo, o -1 si no se pudo (el que llama usa fork).
+int
+spawnexec(struct cmd *cmd, int in, int out)
+{
+  struct execcmd *ecmd = (struct execcmd*)cmd;
+  int fdmap[3];
+
+  if(cmd->type != EXEC || ecmd->argv[0] == 0)
+    return -1;
+  fdmap[0] = in;
+  fdmap[1] = out;
+  fdmap[2] = 2;
+  return spawn(ecmd->argv[0], ecmd->argv, fdmap, 3);
+}
+
+// Camino rapido para comandos simples (solo palabras y < > >>):
+// los lanza con spawn() sin copiar la shell con fork().
+// No usa parsecmd() porque ese hace panic (y saldria de la shell)
+// con errores de sintaxis.
+// Devuelve el pid del hijo, o -1 si hay que usar el camino lento.
+int
+spawnsimple(char *s)
+{
+  char *argv[MAXARGS], *eargv[MAXARGS];
+  char *file[MAXARGS], *efile[MAXARGS];
+  int mode[MAXARGS], rfd[MAXARGS], opened[MAXARGS];
+  int fdmap[3] = { 0, 1, 2 };
+  int argc = 0, nredir = 0, tok, i, pid;
+  char *es = s + strlen(s), *q, *eq;
+
+  while((tok = gettoken(&s, es, &q, &eq)) != 0){
+    if(tok == 'a'){
+      if(argc >= MAXARGS - 1)
+        return -1;
+      argv[argc] = q;
+      eargv[argc++] = eq;
+    } else if(tok == '<' || tok == '>' || tok == '+'){
+      if(nredir >= MAXARGS || gettoken(&s, es, &q, &eq) != 'a')
+        return -1;
+      file[nredir] = q;
+      efile[nredir] = eq;
+      if(tok == '<'){
+        mode[nredir] = O_RDONLY;
+        rfd[nredir] = 0;
+      } else if(tok == '>'){
+        mode[nredir] = O_WRONLY|O_CREATE|MODE_TRUNC;
+        rfd[nredir] = 1;
+      } else {
+        mode[nredir] = O_RDWR|O_CREATE|MODE_APPEND;
+        rfd[nredir] = 1;
+      }
+      nredir++;
+    } else {
+      return -1;   // ( ) u otra cosa: que lo maneje runcmd
+    }
+  }
+  if(argc == 0)
+    return -1;
+  argv[argc] = 0;
+  for(i = 0; i < argc; i++)
+    *eargv[i] = 0;
+  for(i = 0; i < nredir; i++)
+    *efile[i] = 0;
+
+  // Abre los archivos como lo haria runcmd: la ultima redireccion
+  // del texto se aplica primero, asi que gana la primera.
+  for(i = nredir - 1; i >= 0; i--){
+    int m = mode[i] & ~(MODE_TRUNC | MODE_APPEND);
+    if(mode[i] & MODE_TRUNC)
+      unlink(file[i]);
+    if((opened[i] = open(file[i], m)) < 0){
+      while(++i < nredir)
+        close(opened[i]);
+      return -1;
+    }
+    if(mode[i] & MODE_APPEND){
+      char tmpbuf[BUF_SIZE];
+      while(read(opened[i], tmpbuf, sizeof(tmpbuf)) > 0)
+        ;
+    }
+    fdmap[rfd[i]] = opened[i];
+  }
+
+  pid = spawn(argv[0], argv, fdmap, 3);
+
+  for(i = 0; i < nredir; i++)
+    close(opened[i]);
+  return pid;
+}
+
 // Lee lo que el usuario escribe
 int
 getcmd(char *buf, int nbuf)
@@ -1083,6 +1180,13 @@ main(void)
       strcpy(builtin_buf, cmd);
       if (handle_builtin(builtin_buf))
         continue;
+
+      // Si es externo, intenta lanzarlo con spawn() sin fork
+      strcpy(builtin_buf, cmd);
+      if (spawnsimple(builtin_buf) > 0) {
+        wait(0);
+        continue;
+      }
     }
 
     // Si es externo o complejo, lo ejecuta aparte
@@ -0,0 +1,31 @@
+// Timing for the benchmarks in user/. start() lets user
+// mode read the time CSR, so the clock costs no system call
+// and counts in tenths of a microsecond rather than ticks.
+
+// nanoseconds since boot.
+static inline uint64
+benchnow(void)
+{
+  uint64 x;
+  asm volatile("csrr %0, time" : "=r" (x) );
+  return x * (1000000000 / TIMEFREQ);
+}
+
+// print ns nanoseconds as milliseconds.
+static inline void
+benchms(uint64 ns)
+{
+  printf("%d.%03d ms", (int)(ns / 1000000), (int)(ns / 1000 % 1000));
+}
+
+// print "n what in <ms>, <rate> what/sec" and a newline,
+// for n things done in ns nanoseconds.
+static inline void
+benchrate(uint64 n, char *what, uint64 ns)
+{
+  if(ns == 0)
+    ns = 1;
+  printf("%d %s in ", (int)n, what);
+  benchms(ns);
+  printf(", %d %s/sec\n", (int)(n * 1000000000 / ns), what);
+}
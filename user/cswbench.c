@@ -0,0 +1,84 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Measure the context switch rate. npair pairs of processes
+// bounce a byte back and forth through two pipes, so every
+// round trip puts each process to sleep and wakes the other.
+// Compare runs with different numbers of CPUs, e.g. boot
+// with make qemu CPUS=1, CPUS=3 and CPUS=8 and run
+// cswbench 1000 1, then cswbench 1000 4.
+//
+//   cswbench [rounds [npair]]
+
+void
+bounce(int rfd, int wfd, int rounds, int first)
+{
+  char c = 'x';
+
+  for(int i = 0; i < rounds; i++){
+    if(first && write(wfd, &c, 1) != 1)
+      exit(1);
+    if(read(rfd, &c, 1) != 1)
+      exit(1);
+    if(!first && write(wfd, &c, 1) != 1)
+      exit(1);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, rounds = 1000, npair = 2, xstatus;
+  uint64 t0;
+  int ab[2], ba[2];
+
+  if(argc > 1)
+    rounds = atoi(argv[1]);
+  if(argc > 2)
+    npair = atoi(argv[2]);
+  if(rounds < 1 || npair < 1 || npair > 16){
+    fprintf(2, "usage: cswbench [rounds [npair]]\n");
+    exit(1);
+  }
+
+  t0 = benchnow();
+  for(i = 0; i < npair; i++){
+    if(pipe(ab) < 0 || pipe(ba) < 0){
+      fprintf(2, "cswbench: pipe failed\n");
+      exit(1);
+    }
+    for(int side = 0; side < 2; side++){
+      int pid = fork();
+      if(pid < 0){
+        fprintf(2, "cswbench: fork failed\n");
+        exit(1);
+      }
+      if(pid == 0){
+        if(side == 0)
+          bounce(ba[0], ab[1], rounds, 1);
+        else
+          bounce(ab[0], ba[1], rounds, 0);
+        exit(0);
+      }
+    }
+    close(ab[0]);
+    close(ab[1]);
+    close(ba[0]);
+    close(ba[1]);
+  }
+  for(i = 0; i < 2 * npair; i++){
+    wait(&xstatus);
+    if(xstatus != 0){
+      fprintf(2, "cswbench: a child failed\n");
+      exit(1);
+    }
+  }
+
+  // each round trip is two switches per pair.
+  printf("cswbench: %d pairs x %d round trips: ", npair, rounds);
+  benchrate(2 * npair * rounds, "switches", benchnow() - t0);
+  exit(0);
+}
@@ -0,0 +1,52 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "user/user.h"
+
+// Show how well the kernel's inode table (NINODE in
+// kernel/param.h) is working. With a command, report only
+// the lookups made while it ran:
+//
+//   icstat [command [args...]]
+
+void
+show(struct icachestat *st, uint64 hits, uint64 misses)
+{
+  uint64 total = hits + misses;
+
+  printf("icache: %d/%d entries in use, %d hits, %d misses",
+         st->inuse, st->size, (int)hits, (int)misses);
+  if(total > 0)
+    printf(", %d%% hit rate", (int)(hits * 100 / total));
+  printf("\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct icachestat before, after;
+
+  if(icachestat(&before) < 0){
+    fprintf(2, "icstat: icachestat failed\n");
+    exit(1);
+  }
+  if(argc < 2){
+    show(&before, before.hits, before.misses);
+    exit(0);
+  }
+
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "icstat: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "icstat: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+
+  icachestat(&after);
+  show(&after, after.hits - before.hits, after.misses - before.misses);
+  exit(0);
+}
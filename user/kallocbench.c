@@ -0,0 +1,78 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Measure physical page allocator throughput.
+// Forks nproc workers that each create and close pipes
+// for ms milliseconds; every pipe() kallocs 1 + PIPEPAGES
+// pages, the struct pipe and its buffer, and every final
+// close() kfrees them. Run under make CPUS=1 .. CPUS=8 qemu
+// to see how kalloc scales.
+//
+//   kallocbench [nproc] [ms]
+
+#define NWORKER 8
+
+int
+main(int argc, char *argv[])
+{
+  int nproc = 4, dur = 3000;
+  int fds[2], res[2];
+  int i, n, total = 0;
+
+  if(argc > 1)
+    nproc = atoi(argv[1]);
+  if(argc > 2)
+    dur = atoi(argv[2]);
+  if(nproc < 1 || nproc > NWORKER || dur < 1){
+    fprintf(2, "usage: kallocbench [nproc 1-%d] [ms]\n", NWORKER);
+    exit(1);
+  }
+
+  if(pipe(res) < 0){
+    fprintf(2, "kallocbench: pipe failed\n");
+    exit(1);
+  }
+
+  uint64 start = benchnow();
+  for(i = 0; i < nproc; i++){
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "kallocbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      close(res[0]);
+      n = 0;
+      while(benchnow() - start < dur * 1000000ULL){
+        if(pipe(fds) < 0){
+          fprintf(2, "kallocbench: pipe failed\n");
+          exit(1);
+        }
+        close(fds[0]);
+        close(fds[1]);
+        n++;
+      }
+      write(res[1], &n, sizeof(n));
+      exit(0);
+    }
+  }
+  close(res[1]);
+
+  for(i = 0; i < nproc; i++){
+    if(read(res[0], &n, sizeof(n)) != sizeof(n)){
+      fprintf(2, "kallocbench: lost a worker\n");
+      exit(1);
+    }
+    total += n;
+  }
+  for(i = 0; i < nproc; i++)
+    wait(0);
+  uint64 elapsed = benchnow() - start;
+
+  printf("kallocbench: %d procs, ", nproc);
+  benchrate((uint64)total * (1 + PIPEPAGES), "allocs", elapsed);
+  exit(0);
+}
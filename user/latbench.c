@@ -0,0 +1,86 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Measure how long short shell commands take while the CPUs
+// are busy. Starts nhog processes that spin, then runs
+// "echo x" ncmd times the way EAFITossh runs it, first with
+// the hogs at the default priority and then with them
+// lowered by nice(). To load the machine with real work,
+// start grind in the background first (grind &) and use
+// nhog 0.
+//
+//   latbench [ncmd [nhog]]
+
+char *argv[] = { "echo", "x", 0 };
+
+uint64
+runcmds(int n, int fd)
+{
+  int i, fdmap[3];
+  uint64 t0;
+
+  fdmap[0] = 0;
+  fdmap[1] = fd;
+  fdmap[2] = 2;
+  t0 = benchnow();
+  for(i = 0; i < n; i++){
+    if(spawn(argv[0], argv, fdmap, 3) < 0){
+      fprintf(2, "latbench: spawn %s failed\n", argv[0]);
+      exit(1);
+    }
+    wait(0);
+  }
+  return benchnow() - t0;
+}
+
+int
+main(int argc, char *args[])
+{
+  int i, n = 50, nhog = 3, fd;
+  int pids[NPROC];
+
+  if(argc > 1)
+    n = atoi(args[1]);
+  if(argc > 2)
+    nhog = atoi(args[2]);
+  if(n < 1 || nhog < 0 || nhog > NPROC / 2){
+    fprintf(2, "usage: latbench [ncmd [nhog]]\n");
+    exit(1);
+  }
+
+  fd = open("latbench.out", O_CREATE|O_WRONLY);
+  if(fd < 0){
+    fprintf(2, "latbench: cannot create latbench.out\n");
+    exit(1);
+  }
+
+  for(i = 0; i < nhog; i++){
+    if((pids[i] = fork()) < 0){
+      fprintf(2, "latbench: fork failed\n");
+      exit(1);
+    }
+    if(pids[i] == 0)
+      for(;;)
+        ;
+  }
+
+  printf("latbench: %d hogs: ", nhog);
+  benchrate(n, "commands", runcmds(n, fd));
+
+  for(i = 0; i < nhog; i++)
+    nice(pids[i], NMLFQ - 1);
+  printf("latbench: %d niced hogs: ", nhog);
+  benchrate(n, "commands", runcmds(n, fd));
+
+  for(i = 0; i < nhog; i++){
+    kill(pids[i]);
+    wait(0);
+  }
+  close(fd);
+  unlink("latbench.out");
+  exit(0);
+}
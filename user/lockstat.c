@@ -0,0 +1,84 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+
+// Show which kernel locks are contended, from the counts the
+// kernel keeps for each lock name (see kernel/spinlock.c): spin
+// locks, by cycles spent waiting, then sleep locks, by
+// microseconds, longest waits first. With a command, report
+// only the acquisitions made while it ran:
+//
+//   lockstat [command [args...]]
+
+struct lockstat before[NLOCKSTAT], after[NLOCKSTAT];
+
+void
+show(int n0, int n)
+{
+  struct lockstat *l, *best;
+  int i, j, sleep;
+
+  // subtract the counts from before the command; locks
+  // first seen while it ran come after the others.
+  for(i = 0; i < n0 && i < n; i++){
+    after[i].acquires -= before[i].acquires;
+    after[i].contended -= before[i].contended;
+    after[i].wait -= before[i].wait;
+  }
+
+  printf("lock            kind\tcount\tcontend\twait\n");
+  for(sleep = 0; sleep < 2; sleep++){
+    for(i = 0; i < n; i++){
+      best = 0;
+      for(l = after; l < &after[n]; l++)
+        if(l->acquires > 0 && l->sleep == sleep &&
+           (best == 0 || l->wait > best->wait))
+          best = l;
+      if(best == 0)
+        break;
+      printf("%s", best->name);
+      for(j = strlen(best->name); j < 16; j++)
+        printf(" ");
+      printf("%s\t%d\t%d\t", sleep ? "sleep" : "spin",
+             (int)best->acquires, (int)best->contended);
+      if(sleep)
+        printf("%ld us\n", best->wait * 1000000 / TIMEFREQ);
+      else
+        printf("%ld cycles\n", best->wait);
+      best->acquires = 0;
+    }
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int n0, n;
+
+  if((n0 = lockstat(before, NLOCKSTAT)) < 0){
+    fprintf(2, "lockstat: lockstat failed\n");
+    exit(1);
+  }
+  if(argc < 2){
+    memmove(after, before, sizeof(before));
+    show(0, n0);
+    exit(0);
+  }
+
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "lockstat: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "lockstat: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+
+  n = lockstat(after, NLOCKSTAT);
+  show(n0, n);
+  exit(0);
+}
@@ -0,0 +1,100 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Measure path lookup speed in a big directory. Creates
+// nfile files in lbdir, then stat()s each of them plus
+// the same number of missing names, the way a shell's ls
+// or a PATH search does. The first pass has to scan the
+// directory; later passes can be answered by the kernel's
+// directory name cache (NDCACHE in kernel/param.h).
+//
+//   lookupbench [nfile [passes]]
+//
+// nfile is at most MAXNFILE, leaving some of mkfs's 1000 inodes
+// for the files already on the disk.
+
+#define MAXNFILE 900
+
+char path[32];
+
+void
+mkname(char c, int i)
+{
+  strcpy(path, "lbdir/");
+  path[6] = c;
+  path[7] = '0' + i / 100 % 10;
+  path[8] = '0' + i / 10 % 10;
+  path[9] = '0' + i % 10;
+  path[10] = '\0';
+}
+
+// remove lbdir and the first n files in it.
+void
+cleanup(int n)
+{
+  int i;
+
+  for(i = 0; i < n; i++){
+    mkname('f', i);
+    unlink(path);
+  }
+  unlink("lbdir");
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, fd, pass, nfile = 300, passes = 5;
+  uint64 t0;
+  struct stat st;
+
+  if(argc > 1)
+    nfile = atoi(argv[1]);
+  if(argc > 2)
+    passes = atoi(argv[2]);
+  if(nfile < 1 || nfile > MAXNFILE || passes < 1){
+    fprintf(2, "usage: lookupbench [nfile 1-%d [passes]]\n", MAXNFILE);
+    exit(1);
+  }
+
+  if(mkdir("lbdir") < 0){
+    fprintf(2, "lookupbench: cannot mkdir lbdir\n");
+    exit(1);
+  }
+  for(i = 0; i < nfile; i++){
+    mkname('f', i);
+    if((fd = open(path, O_CREATE|O_WRONLY)) < 0){
+      fprintf(2, "lookupbench: cannot create %s\n", path);
+      cleanup(i);
+      exit(1);
+    }
+    close(fd);
+  }
+
+  for(pass = 0; pass < passes; pass++){
+    t0 = benchnow();
+    for(i = 0; i < nfile; i++){
+      mkname('f', i);
+      if(stat(path, &st) < 0){
+        fprintf(2, "lookupbench: stat %s failed\n", path);
+        cleanup(nfile);
+        exit(1);
+      }
+      mkname('g', i);
+      if(stat(path, &st) >= 0){
+        fprintf(2, "lookupbench: %s should not exist\n", path);
+        cleanup(nfile);
+        exit(1);
+      }
+    }
+    printf("lookupbench: pass %d: ", pass);
+    benchrate(2 * nfile, "lookups", benchnow() - t0);
+  }
+
+  cleanup(nfile);
+  exit(0);
+}
@@ -0,0 +1,86 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Compare reading a file with read() and with mmap(): write an
+// NBLOCK-block file, then sum its bytes both ways. read() copies
+// every block from the buffer cache into buf; mmap() copies each
+// page into memory once when it is faulted in and then lets the
+// program touch it directly.
+//
+//   mmapbench [passes]
+
+#define NBLOCK 1024
+
+char buf[BSIZE];
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i, n, passes = 3;
+  char *file = "mmapbench.dat", *a;
+  uint sum, sum0 = 0;
+
+  if(argc > 1)
+    passes = atoi(argv[1]);
+
+  fd = open(file, O_CREATE|O_WRONLY);
+  if(fd < 0){
+    fprintf(2, "mmapbench: cannot create %s\n", file);
+    exit(1);
+  }
+  for(i = 0; i < NBLOCK; i++){
+    memset(buf, 'a' + i % 26, sizeof(buf));
+    sum0 += ('a' + i % 26) * sizeof(buf);
+    if(write(fd, buf, sizeof(buf)) != sizeof(buf)){
+      fprintf(2, "mmapbench: write failed at block %d\n", i);
+      exit(1);
+    }
+  }
+  close(fd);
+
+  for(int pass = 0; pass < passes; pass++){
+    // read(): one system call and one copy per block.
+    fd = open(file, O_RDONLY);
+    uint64 start = benchnow();
+    sum = 0;
+    while((n = read(fd, buf, sizeof(buf))) > 0)
+      for(i = 0; i < n; i++)
+        sum += (uchar)buf[i];
+    uint64 tread = benchnow() - start;
+    if(sum != sum0){
+      fprintf(2, "mmapbench: read() sum is wrong\n");
+      exit(1);
+    }
+
+    // mmap(): faults bring the pages in, faultaround() at a time.
+    start = benchnow();
+    a = mmap(0, NBLOCK*BSIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(a == (char*)-1){
+      fprintf(2, "mmapbench: mmap failed\n");
+      exit(1);
+    }
+    sum = 0;
+    for(i = 0; i < NBLOCK*BSIZE; i++)
+      sum += (uchar)a[i];
+    munmap(a, NBLOCK*BSIZE);
+    uint64 tmap = benchnow() - start;
+    close(fd);
+    if(sum != sum0){
+      fprintf(2, "mmapbench: mmap() sum is wrong\n");
+      exit(1);
+    }
+
+    printf("mmapbench: pass %d: read() ", pass);
+    benchrate(NBLOCK*BSIZE / 1024, "KB", tread);
+    printf("mmapbench: pass %d: mmap() ", pass);
+    benchrate(NBLOCK*BSIZE / 1024, "KB", tmap);
+  }
+
+  unlink(file);
+  exit(0);
+}
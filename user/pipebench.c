@@ -0,0 +1,81 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Measure pipe throughput: a child writes nkb kilobytes
+// into a pipe in bufsz-byte writes, the parent reads
+// them back and checks the byte pattern.
+//
+//   pipebench [nkb] [bufsz]
+
+#define MAXBUF 8192
+
+char buf[MAXBUF];
+
+int
+main(int argc, char *argv[])
+{
+  int fds[2], nkb = 4096, bufsz = 4096, n, i;
+  uint total, got = 0;
+
+  if(argc > 1)
+    nkb = atoi(argv[1]);
+  if(argc > 2)
+    bufsz = atoi(argv[2]);
+  if(nkb < 1 || bufsz < 1 || bufsz > MAXBUF){
+    fprintf(2, "usage: pipebench [nkb] [bufsz 1-%d]\n", MAXBUF);
+    exit(1);
+  }
+  total = (uint)nkb * 1024;
+
+  if(pipe(fds) < 0){
+    fprintf(2, "pipebench: pipe failed\n");
+    exit(1);
+  }
+
+  uint64 start = benchnow();
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "pipebench: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    uint sent = 0;
+    close(fds[0]);
+    while(sent < total){
+      n = total - sent < bufsz ? total - sent : bufsz;
+      for(i = 0; i < n; i++)
+        buf[i] = (sent + i) & 0xff;
+      if(write(fds[1], buf, n) != n){
+        fprintf(2, "pipebench: write failed\n");
+        exit(1);
+      }
+      sent += n;
+    }
+    exit(0);
+  }
+
+  close(fds[1]);
+  while((n = read(fds[0], buf, bufsz)) > 0){
+    for(i = 0; i < n; i++){
+      if((uchar)buf[i] != ((got + i) & 0xff)){
+        fprintf(2, "pipebench: wrong byte at %d\n", got + i);
+        exit(1);
+      }
+    }
+    got += n;
+  }
+  close(fds[0]);
+  wait(0);
+  uint64 elapsed = benchnow() - start;
+
+  if(got != total){
+    fprintf(2, "pipebench: read %d bytes, expected %d\n", got, total);
+    exit(1);
+  }
+  printf("pipebench: ");
+  benchrate(nkb, "KB", elapsed);
+  exit(0);
+}
@@ -0,0 +1,59 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Measure pipe ping-pong latency: two processes pass one
+// byte back and forth through a pair of pipes, so each
+// round trip is two sleep()/wakeup() pairs in the kernel.
+//
+//   pplat [rounds]
+
+int
+main(int argc, char *argv[])
+{
+  int i, rounds = 2000, pid;
+  uint64 t0, t;
+  int ping[2], pong[2];
+  char c = 'x';
+
+  if(argc > 1)
+    rounds = atoi(argv[1]);
+  if(rounds < 1){
+    fprintf(2, "usage: pplat [rounds]\n");
+    exit(1);
+  }
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    fprintf(2, "pplat: pipe failed\n");
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    fprintf(2, "pplat: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    for(i = 0; i < rounds; i++){
+      if(read(ping[0], &c, 1) != 1 || write(pong[1], &c, 1) != 1)
+        exit(1);
+    }
+    exit(0);
+  }
+
+  t0 = benchnow();
+  for(i = 0; i < rounds; i++){
+    if(write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1){
+      fprintf(2, "pplat: round %d failed\n", i);
+      exit(1);
+    }
+  }
+  t = benchnow() - t0;
+  wait(0);
+
+  printf("pplat: ");
+  benchrate(rounds, "round trips", t);
+  printf("pplat: %d ns each\n", (int)(t / rounds));
+  exit(0);
+}
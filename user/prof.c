@@ -0,0 +1,155 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/prof.h"
+#include "user/user.h"
+
+// Profile a command: sample every CPU's pc while it runs (see
+// kernel/prof.c) and list the addresses hit most, user ones by
+// pid and kernel ones together. Look the addresses up in
+// kernel/kernel.sym or user/<program>.sym.
+//
+//   prof [-i us] [-n top] command [args...]
+
+#define NHASH 1024  // distinct addresses counted
+#define NBUF  64
+
+struct hit {
+  uint64 pc;
+  int pid;      // 0 for the kernel
+  int n;
+} hits[NHASH];
+
+struct profsample buf[NBUF];
+int total, lost, other;
+
+void
+count(struct profsample *s)
+{
+  int pid = s->user ? s->pid : 0;
+  uint h = (uint)(s->pc >> 1) * 31 + pid;
+  int i;
+
+  total++;
+  for(i = 0; i < NHASH; i++){
+    struct hit *e = &hits[(h + i) % NHASH];
+    if(e->n == 0){
+      e->pc = s->pc;
+      e->pid = pid;
+    }
+    if(e->pc == s->pc && e->pid == pid){
+      e->n++;
+      return;
+    }
+  }
+  other++;
+}
+
+// read samples until profiling is off and none are left.
+void
+drain(int self)
+{
+  int i, n, off;
+
+  for(;;){
+    off = profile(-1) == 0;
+    if((n = profread(buf, NBUF)) < 0){
+      fprintf(2, "prof: profread failed\n");
+      return;
+    }
+    for(i = 0; i < n; i++){
+      if(buf[i].pc == 0)
+        lost += buf[i].pid;
+      else if(buf[i].pid != self)
+        count(&buf[i]);
+    }
+    if(n == 0){
+      if(off)
+        return;
+      nsleep(20 * 1000 * 1000);
+    }
+  }
+}
+
+void
+report(int top)
+{
+  struct hit *e, *best;
+  int i;
+
+  printf("%d samples", total);
+  if(lost)
+    printf(", %d lost", lost);
+  printf("\n");
+  if(total == 0)
+    return;
+  printf("  count    %%  where\n");
+  for(i = 0; i < top; i++){
+    best = 0;
+    for(e = hits; e < &hits[NHASH]; e++)
+      if(e->n > 0 && (best == 0 || e->n > best->n))
+        best = e;
+    if(best == 0)
+      break;
+    printf("%d\t%d%%\t", best->n, best->n * 100 / total);
+    if(best->pid)
+      printf("pid %d\t0x%lx\n", best->pid, best->pc);
+    else
+      printf("kernel\t0x%lx\n", best->pc);
+    best->n = -best->n;
+  }
+  if(other)
+    printf("%d\t%d%%\tother\n", other, other * 100 / total);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int us = 1000, top = 20, pid, i;
+
+  for(i = 1; i + 1 < argc && argv[i][0] == '-'; i += 2){
+    if(strcmp(argv[i], "-i") == 0)
+      us = atoi(argv[i+1]);
+    else if(strcmp(argv[i], "-n") == 0)
+      top = atoi(argv[i+1]);
+    else
+      break;
+  }
+  if(i >= argc || argv[i][0] == '-'){
+    fprintf(2, "Usage: prof [-i us] [-n top] command [args...]\n");
+    exit(1);
+  }
+
+  // drop what an earlier run left behind.
+  while(profread(buf, NBUF) > 0)
+    ;
+
+  if(profile(us) < 0){
+    fprintf(2, "prof: can't sample every %d us\n", us);
+    exit(1);
+  }
+
+  // a child runs the command and turns profiling off when it
+  // is done, while this process drains the samples.
+  pid = fork();
+  if(pid < 0){
+    fprintf(2, "prof: fork failed\n");
+    profile(0);
+    exit(1);
+  }
+  if(pid == 0){
+    pid = fork();
+    if(pid == 0){
+      exec(argv[i], argv + i);
+      fprintf(2, "prof: exec %s failed\n", argv[i]);
+      exit(1);
+    }
+    if(pid > 0)
+      wait(0);
+    profile(0);
+    exit(0);
+  }
+  drain(getpid());
+  wait(0);
+  report(top);
+  exit(0);
+}
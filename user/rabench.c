@@ -0,0 +1,77 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/fs.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Measure sequential read speed: write an NBLOCK-block
+// file, then time cat reading it into a pipe. The file
+// is much bigger than the buffer cache, so its first
+// blocks have to come from the disk, and read-ahead
+// (READAHEAD in kernel/param.h) decides how many disk
+// round trips cat waits for.
+//
+//   rabench [passes]
+
+#define NBLOCK 1024
+
+char buf[BSIZE];
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i, n, passes = 3, fds[2];
+  int fdmap[3];
+  char *file = "rabench.dat";
+  char *cargv[] = { "cat", file, 0 };
+
+  if(argc > 1)
+    passes = atoi(argv[1]);
+
+  fd = open(file, O_CREATE|O_WRONLY);
+  if(fd < 0){
+    fprintf(2, "rabench: cannot create %s\n", file);
+    exit(1);
+  }
+  for(i = 0; i < NBLOCK; i++){
+    memset(buf, 'a' + i % 26, sizeof(buf));
+    if(write(fd, buf, sizeof(buf)) != sizeof(buf)){
+      fprintf(2, "rabench: write failed at block %d\n", i);
+      exit(1);
+    }
+  }
+  close(fd);
+
+  for(int pass = 0; pass < passes; pass++){
+    if(pipe(fds) < 0){
+      fprintf(2, "rabench: pipe failed\n");
+      exit(1);
+    }
+    fdmap[0] = 0;
+    fdmap[1] = fds[1];
+    fdmap[2] = 2;
+    uint64 start = benchnow();
+    if(spawn(cargv[0], cargv, fdmap, 3) < 0){
+      fprintf(2, "rabench: spawn cat failed\n");
+      exit(1);
+    }
+    close(fds[1]);
+    int total = 0;
+    while((n = read(fds[0], buf, sizeof(buf))) > 0)
+      total += n;
+    close(fds[0]);
+    wait(0);
+    uint64 elapsed = benchnow() - start;
+    if(total != NBLOCK*BSIZE){
+      fprintf(2, "rabench: cat returned %d bytes, expected %d\n", total, NBLOCK*BSIZE);
+      exit(1);
+    }
+    printf("rabench: pass %d: ", pass);
+    benchrate(total / 1024, "KB", elapsed);
+  }
+
+  unlink(file);
+  exit(0);
+}
@@ -0,0 +1,98 @@
+// Stress the buffer cache with concurrent readers.
+// Creates one small file per reader, then forks the
+// readers, each of which re-reads its own file over and
+// over; with a hashed buffer cache, readers of different
+// blocks shouldn't serialize on a single lock.
+//
+//   readstress [nreaders] [passes]
+
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "kernel/fs.h"
+#include "kernel/fcntl.h"
+#include "user/bench.h"
+
+#define NREADER 8
+#define NBLOCK  4   // blocks per file; keep the working set under NBUF
+
+int
+main(int argc, char *argv[])
+{
+  int fd, i, j, k, nreaders = 4, passes = 200;
+  char path[] = "rstress0";
+  char data[BSIZE];
+
+  if(argc > 1)
+    nreaders = atoi(argv[1]);
+  if(argc > 2)
+    passes = atoi(argv[2]);
+  if(nreaders < 1 || nreaders > NREADER || passes < 1){
+    fprintf(2, "usage: readstress [nreaders 1-%d] [passes]\n", NREADER);
+    exit(1);
+  }
+
+  printf("readstress starting\n");
+
+  for(i = 0; i < nreaders; i++){
+    path[7] = '0' + i;
+    memset(data, 'a' + i, sizeof(data));
+    fd = open(path, O_CREATE | O_RDWR);
+    if(fd < 0){
+      fprintf(2, "readstress: create %s failed\n", path);
+      exit(1);
+    }
+    for(j = 0; j < NBLOCK; j++)
+      write(fd, data, sizeof(data));
+    close(fd);
+  }
+
+  uint64 start = benchnow();
+  for(i = 0; i < nreaders; i++){
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "readstress: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      path[7] = '0' + i;
+      for(j = 0; j < passes; j++){
+        fd = open(path, O_RDONLY);
+        if(fd < 0){
+          fprintf(2, "readstress: open %s failed\n", path);
+          exit(1);
+        }
+        for(k = 0; k < NBLOCK; k++){
+          if(read(fd, data, sizeof(data)) != sizeof(data) || data[0] != 'a' + i){
+            fprintf(2, "readstress: bad read of %s\n", path);
+            exit(1);
+          }
+        }
+        close(fd);
+      }
+      exit(0);
+    }
+  }
+
+  int xstatus, failed = 0;
+  for(i = 0; i < nreaders; i++){
+    wait(&xstatus);
+    if(xstatus != 0)
+      failed = 1;
+  }
+  uint64 elapsed = benchnow() - start;
+
+  for(i = 0; i < nreaders; i++){
+    path[7] = '0' + i;
+    unlink(path);
+  }
+
+  if(failed){
+    printf("readstress: FAILED\n");
+    exit(1);
+  }
+  printf("readstress: %d readers x %d passes, ", nreaders, passes);
+  benchrate((uint64)nreaders * passes * NBLOCK, "reads", elapsed);
+  exit(0);
+}
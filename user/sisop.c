@@ -97,7 +97,7 @@ main(void)
 
 	printf("\n=== Simulacion de Memoria Compartida (Shared Memory) ===\n");
 	printf("Explicacion del flujo en ejecucion:\n");
-	printf("1. El Padre (Renderizador) abre o crea la memoria compartida mediante shm_open().\n");
+	printf("1. El Padre (Renderizador) abre o crea el segmento \"sisop\" mediante shm_open().\n");
 	printf("2. El Padre hace fork() para crear al Hijo (Principal). \n");
 	printf("   Ambos procesos heredan la misma tabla de paginas inicial pero mantienen \n");
 	printf("   su acceso a la direccion fisica compartida.\n");
@@ -120,7 +120,7 @@ main(void)
 
 	printf("\n[Sistema] Inicializando memoria compartida (shm_open)...\n");
 
-	shm = (SharedData *)shm_open();
+	shm = (SharedData *)shm_open("sisop", sizeof(SharedData), 0);
 	if(shm == (void *)-1){
 		printf("Error: shm_open fallo\n");
 		exit(1);
@@ -138,14 +138,9 @@ main(void)
 	// Hijo = Principal. Padre = Renderizador.
 	// Asi evitamos que aparezca el prompt "$" del shell en medio del render.
 	if(pid == 0){
-		// Como uvmcopy (al hacer fork) no clona direcciones altas por encima de p->sz,
-		// el proceso hijo debe "vincularse" explícitamente a la memoria compartida.
+		// fork() hereda el segmento: el hijo lo ve en la misma VA
+		// y sobre las mismas páginas físicas, sin volver a abrirlo.
 		printf("[Principal] PID Hijo=%d\n", getpid());
-		shm = (SharedData *)shm_open();
-		if(shm == (void *)-1){
-			printf("Error: Hijo fallo shm_open\n");
-			exit(1);
-		}
 
 		shm->char_count = 0;
 		shm->done = 0;
@@ -156,7 +151,7 @@ main(void)
 
 		printf("\n--- Fase 2: Principal termina operacion ---\n");
 		printf("[Principal] Cerrando conexion a memoria compartida (shm_close) y finalizando.\n");
-		shm_close();
+		shm_close(shm);
 		exit(0);
 	}
 
@@ -165,7 +160,7 @@ main(void)
 
 	// Recolecta al hijo para cerrar limpio y sin artefactos de consola.
 	wait(&status);
-	shm_close();
+	shm_close(shm);
 
 	printf("=== Flujo completado sin perdida de memoria compartida ===\n\n");
 	exit(0);
@@ -0,0 +1,77 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/fcntl.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Compare external commands per second when the shell
+// starts them with fork()+exec() versus spawn().
+// Each iteration runs "echo x" with its output sent
+// to a scratch file, the way EAFITossh runs "echo x > f".
+//
+//   spawnbench [iterations]
+
+char *argv[] = { "echo", "x", 0 };
+
+int
+main(int argc, char *args[])
+{
+  int i, n = 100, fd;
+  uint64 t0, tfork, tspawn;
+  int fdmap[3];
+
+  if(argc > 1)
+    n = atoi(args[1]);
+  if(n < 1){
+    fprintf(2, "usage: spawnbench [iterations]\n");
+    exit(1);
+  }
+
+  fd = open("spawnbench.out", O_CREATE|O_WRONLY);
+  if(fd < 0){
+    fprintf(2, "spawnbench: cannot create spawnbench.out\n");
+    exit(1);
+  }
+
+  t0 = benchnow();
+  for(i = 0; i < n; i++){
+    int pid = fork();
+    if(pid < 0){
+      fprintf(2, "spawnbench: fork failed\n");
+      exit(1);
+    }
+    if(pid == 0){
+      close(1);
+      dup(fd);
+      close(fd);
+      exec(argv[0], argv);
+      fprintf(2, "spawnbench: exec %s failed\n", argv[0]);
+      exit(1);
+    }
+    wait(0);
+  }
+  tfork = benchnow() - t0;
+
+  fdmap[0] = 0;
+  fdmap[1] = fd;
+  fdmap[2] = 2;
+  t0 = benchnow();
+  for(i = 0; i < n; i++){
+    if(spawn(argv[0], argv, fdmap, 3) < 0){
+      fprintf(2, "spawnbench: spawn %s failed\n", argv[0]);
+      exit(1);
+    }
+    wait(0);
+  }
+  tspawn = benchnow() - t0;
+
+  close(fd);
+  unlink("spawnbench.out");
+
+  printf("spawnbench: fork+exec: ");
+  benchrate(n, "cmds", tfork);
+  printf("spawnbench: spawn:     ");
+  benchrate(n, "cmds", tspawn);
+  exit(0);
+}
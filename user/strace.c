@@ -1,29 +1,119 @@
 #include "kernel/types.h"
 #include "kernel/stat.h"
+#include "kernel/syscall.h"
+#include "kernel/trace.h"
 #include "user/user.h"
+#include "user/sysnames.h"
+
+// Run a command with the system calls in mask traced, and
+// print each traced call as the kernel recorded it (see
+// kernel/trace.c): pid, name, the first arguments, the
+// return value, and how long the call took.
+//
+//   strace mask|all command [args...]
+//
+// Bit n of mask, in decimal or 0x hex, traces system call n.
+
+#define NEV 32
+
+struct traceev ev[NEV];
+
+void
+print(struct traceev *e)
+{
+  const char *name = "?";
+
+  if(e->num == 0){
+    printf("strace: %d events lost on cpu %d\n", (int)e->args[0], e->cpu);
+    return;
+  }
+  if(e->num > 0 && e->num < sizeof(sysnames)/sizeof(sysnames[0]) && sysnames[e->num])
+    name = sysnames[e->num];
+  if(e->num == SYS_exit){
+    printf("%d %s(%d)\n", e->pid, name, (int)e->args[0]);
+    return;
+  }
+  // the time CSR counts at 10 MHz.
+  printf("%d %s(0x%lx, 0x%lx, 0x%lx) = %ld  <%d us>\n", e->pid, name,
+         e->args[0], e->args[1], e->args[2], (long)e->ret,
+         (int)((e->exit - e->enter) / 10));
+}
+
+// parse a 64-bit mask, in decimal or in hex with 0x;
+// atoi() would stop at 31 bits. returns -1 if s isn't one.
+int
+parsemask(char *s, uint64 *mask)
+{
+  int base = 10, d;
+
+  if(s[0] == '0' && s[1] == 'x'){
+    base = 16;
+    s += 2;
+  }
+  if(*s == 0)
+    return -1;
+  for(*mask = 0; *s; s++){
+    if(*s >= '0' && *s <= '9')
+      d = *s - '0';
+    else if(base == 16 && *s >= 'a' && *s <= 'f')
+      d = *s - 'a' + 10;
+    else
+      return -1;
+    *mask = *mask * base + d;
+  }
+  return 0;
+}
 
 int
 main(int argc, char *argv[])
 {
-  int i;
-  char *nargv[10];
+  uint64 mask;
+  int pid, i, n, done = 0;
 
-  if(argc < 3 || (argv[1][0] < '0' || argv[1][0] > '9')){
-    fprintf(2, "Usage: %s mask command\n", argv[0]);
+  if(argc < 3)
+    mask = 0;
+  else if(strcmp(argv[1], "all") == 0)
+    mask = ~0L;
+  else if(parsemask(argv[1], &mask) < 0)
+    mask = 0;
+  if(mask == 0){
+    fprintf(2, "Usage: %s mask|all command [args...]\n", argv[0]);
     exit(1);
   }
 
-  if (trace(atoi(argv[1])) < 0) {
-    fprintf(2, "%s: trace failed\n", argv[0]);
+  // drop what earlier traces left behind.
+  while(traceread(ev, NEV) > 0)
+    ;
+
+  pid = fork();
+  if(pid < 0){
+    fprintf(2, "%s: fork failed\n", argv[0]);
     exit(1);
   }
-  
-  for(i = 2; i < argc && i < 12; i++){
-    nargv[i-2] = argv[i];
+  if(pid == 0){
+    if(trace(mask) < 0){
+      fprintf(2, "%s: trace failed\n", argv[0]);
+      exit(1);
+    }
+    exec(argv[2], argv + 2);
+    fprintf(2, "exec %s failed\n", argv[2]);
+    exit(1);
   }
-  nargv[i-2] = 0;
 
-  exec(nargv[0], nargv);
-  printf("exec %s failed\n", nargv[0]);
+  // the command's exit is always recorded, so drain until it shows up.
+  while(!done){
+    if((n = traceread(ev, NEV)) < 0){
+      fprintf(2, "%s: traceread failed\n", argv[0]);
+      break;
+    }
+    for(i = 0; i < n; i++){
+      print(&ev[i]);
+      if(ev[i].num == SYS_exit && ev[i].pid == pid)
+        done = 1;
+    }
+    if(n == 0)
+      nsleep(10 * 1000 * 1000);
+  }
+  wait(0);
   exit(0);
 }
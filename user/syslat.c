@@ -0,0 +1,107 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/syscall.h"
+#include "kernel/trace.h"
+#include "user/user.h"
+#include "user/sysnames.h"
+
+// Show how long each system call takes, from the kernel's
+// latency histograms (see kernel/trace.c): the number of calls,
+// and the median and 99th percentile in CPU cycles. Since the
+// histograms are log2, a percentile is shown as the bucket it
+// falls in. Calls that slept and finished on another CPU are
+// left out. With a command, report only the calls made while
+// it ran:
+//
+//   syslat [command [args...]]
+
+uint64 before[NLATSYS][NLATBUCKET];
+uint64 after[NLATSYS][NLATBUCKET];
+
+// print the cycles of bucket b: none for bucket 0, fewer
+// than 2^b otherwise, and at least 2^(b-1) for the last.
+void
+bound(int b)
+{
+  if(b == 0)
+    printf(" 0");
+  else if(b == NLATBUCKET-1)
+    printf(" >=%ld", 1L << (b-1));
+  else
+    printf(" <%ld", 1L << b);
+}
+
+// the bucket holding the call at fraction pct/100 of n.
+int
+percentile(uint64 *h, uint64 n, int pct)
+{
+  uint64 want = (n * pct + 99) / 100, seen = 0;
+  int b;
+
+  for(b = 0; b < NLATBUCKET-1; b++){
+    seen += h[b];
+    if(seen >= want)
+      break;
+  }
+  return b;
+}
+
+void
+show(void)
+{
+  int num, b;
+  uint64 n;
+  const char *name;
+
+  printf("syscall      calls\t p50\t p99 (cycles)\n");
+  for(num = 1; num < NLATSYS; num++){
+    n = 0;
+    for(b = 0; b < NLATBUCKET; b++){
+      after[num][b] -= before[num][b];
+      n += after[num][b];
+    }
+    if(n == 0)
+      continue;
+    name = "?";
+    if(num < sizeof(sysnames)/sizeof(sysnames[0]) && sysnames[num])
+      name = sysnames[num];
+    printf("%s", name);
+    for(b = strlen(name); b < 12; b++)
+      printf(" ");
+    printf(" %d\t", (int)n);
+    bound(percentile(after[num], n, 50));
+    printf("\t");
+    bound(percentile(after[num], n, 99));
+    printf("\n");
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc < 2){
+    if(syslat(&after[0][0]) < 0){
+      fprintf(2, "syslat: syslat failed\n");
+      exit(1);
+    }
+    show();
+    exit(0);
+  }
+
+  syslat(&before[0][0]);
+  int pid = fork();
+  if(pid < 0){
+    fprintf(2, "syslat: fork failed\n");
+    exit(1);
+  }
+  if(pid == 0){
+    exec(argv[1], argv + 1);
+    fprintf(2, "syslat: exec %s failed\n", argv[1]);
+    exit(1);
+  }
+  wait(0);
+
+  syslat(&after[0][0]);
+  show();
+  exit(0);
+}
@@ -0,0 +1,50 @@
+// Names of the system calls, indexed by number, for tools
+// that print what the kernel reports per system call.
+// Include after kernel/syscall.h.
+
+static const char *sysnames[] = {
+[SYS_fork]    "fork",
+[SYS_exit]    "exit",
+[SYS_wait]    "wait",
+[SYS_pipe]    "pipe",
+[SYS_read]    "read",
+[SYS_kill]    "kill",
+[SYS_exec]    "exec",
+[SYS_fstat]   "fstat",
+[SYS_chdir]   "chdir",
+[SYS_dup]     "dup",
+[SYS_getpid]  "getpid",
+[SYS_sbrk]    "sbrk",
+[SYS_pause]   "pause",
+[SYS_uptime]  "uptime",
+[SYS_open]    "open",
+[SYS_write]   "write",
+[SYS_mknod]   "mknod",
+[SYS_unlink]  "unlink",
+[SYS_link]    "link",
+[SYS_mkdir]   "mkdir",
+[SYS_close]   "close",
+[SYS_rtctime] "rtctime",
+[SYS_shm_open] "shm_open",
+[SYS_shm_close] "shm_close",
+[SYS_hello]   "hello",
+[SYS_trace]   "trace",
+[SYS_dumpvm]  "dumpvm",
+[SYS_map_ro]  "map_ro",
+[SYS_mapzero] "mapzero",
+[SYS_spawn]   "spawn",
+[SYS_splice]  "splice",
+[SYS_fsync]   "fsync",
+[SYS_icachestat] "icachestat",
+[SYS_nice]    "nice",
+[SYS_nsleep]  "nsleep",
+[SYS_faultaround] "faultaround",
+[SYS_pfstat]  "pfstat",
+[SYS_mmap]    "mmap",
+[SYS_munmap]  "munmap",
+[SYS_traceread] "traceread",
+[SYS_syslat]  "syslat",
+[SYS_profile] "profile",
+[SYS_profread] "profread",
+[SYS_lockstat] "lockstat",
+};
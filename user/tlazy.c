@@ -7,6 +7,10 @@
  * Prueba la implementación de Lazy Allocation.
  * Debe fallar con un Page Fault al intentar acceder a la memoria
  * que fue "reservada" virtualmente pero no físicamente.
+ *
+ * Uso: tlazy [s|r] [paginas por fallo]
+ * El segundo argumento ajusta faultaround(); 1 mapea una sola
+ * página por fallo.
  */
 
 int
@@ -14,6 +18,13 @@ main(int argc, char *argv[])
 {
   uint64 n_pages = 10;
   uint64 sz = n_pages * 4096;
+  struct pfstat st;
+
+  if (argc > 2 && faultaround(atoi(argv[2])) < 0) {
+    printf("tlazy: faultaround(%s) falló\n", argv[2]);
+    exit(1);
+  }
+
   char *p = sbrk(sz);
   
   if (p == (char*)-1) {
@@ -39,6 +50,11 @@ main(int argc, char *argv[])
     }
   }
 
-  printf("tlazy: Prueba finalizada. Revisa el log del kernel para ver los pf_count.\n");
+  if (pfstat(&st) < 0) {
+    printf("tlazy: pfstat falló\n");
+    exit(1);
+  }
+  printf("tlazy: Prueba finalizada. pf_count=%d paginas=%d (cluster %d)\n",
+         (int)st.faults, (int)st.pages, st.cluster);
   exit(0);
 }
@@ -0,0 +1,74 @@
+#include "kernel/types.h"
+#include "kernel/stat.h"
+#include "kernel/riscv.h"
+#include "kernel/param.h"
+#include "user/user.h"
+#include "user/bench.h"
+
+// Measure TLB reach: touch one word in every page of an
+// NMEG-megabyte, megapage-aligned heap region, over and
+// over, once with megapages (the default, see megafault()
+// in kernel/vm.c) and once with faultaround(1), which maps
+// 4096-byte pages only. Each touch of a new page then
+// needs a TLB entry of its own.
+//
+//   tlbbench [passes]
+
+#define NMEG 8
+
+// touch the region in a child, so that its memory and its
+// faultaround() setting go away with it. cluster -1 keeps
+// the default.
+void
+run(char *what, int cluster, int passes)
+{
+  struct pfstat st;
+  char *cur, *a;
+  int i, pass;
+  uint64 t0, t1, t2;
+  uint sum = 0;
+
+  if(fork() != 0){
+    wait(0);
+    return;
+  }
+  faultaround(cluster);
+  cur = sbrk(0);
+  if(sbrk(MEGASIZE - (uint64)cur % MEGASIZE) == (char*)-1 ||
+     (a = sbrk(NMEG*1024*1024)) == (char*)-1){
+    fprintf(2, "tlbbench: sbrk failed\n");
+    exit(1);
+  }
+
+  t0 = benchnow();
+  for(i = 0; i < NMEG*1024*1024; i += PGSIZE)
+    a[i] = 1;
+  t1 = benchnow();
+  for(pass = 0; pass < passes; pass++)
+    for(i = 0; i < NMEG*1024*1024; i += PGSIZE)
+      sum += a[i];
+  t2 = benchnow();
+  pfstat(&st);
+  if(sum != passes * (NMEG*1024*1024 / PGSIZE)){
+    fprintf(2, "tlbbench: wrong sum\n");
+    exit(1);
+  }
+  printf("tlbbench: %s: %d faults, ", what, (int)st.faults);
+  benchms(t1 - t0);
+  printf(" to fault in, ");
+  benchms(t2 - t1);
+  printf(" for %d passes\n", passes);
+  exit(0);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int passes = 200;
+
+  if(argc > 1)
+    passes = atoi(argv[1]);
+  run("megapages", -1, passes);
+  run("4K pages", 1, passes);
+  exit(0);
+}
@@ -9,13 +9,13 @@ int main() {
   char buf[10];
   int fd;
 
-  // Habilitar el trace de estas syscalls para ver los registros crudos y decodificados
+  // Ejecutar bajo strace para ver los argumentos y resultados:
+  //   strace 167870496 tuargs
   // read(5)  => 32
   // open(15) => 32768
   // write(16)=> 65536
   // hello(25)=> 33554432
   // dumpvm(27)=> 134217728
-  trace(134217728 + 33554432 + 65536 + 32768 + 32);
 
   printf("--- 1. open() con punteros ---\n");
   fd = open("README", O_RDONLY); // Valido
@@ -1,6 +1,11 @@
 #define SBRK_ERROR ((char *)-1)
 
 struct stat;
+struct icachestat;
+struct pfstat;
+struct traceev;
+struct profsample;
+struct lockstat;
 
 // system calls
 int fork(void);
@@ -26,13 +31,28 @@ int pause(int);
 int uptime(void);
 int rtctime(void);
 int hello(void);
-int trace(int);
+int trace(uint64);
 int dumpvm(void);
 int map_ro(void*);
 int mapzero(int);
+int spawn(const char*, char**, int*, int);
+int splice(int, int, int);
+int fsync(int);
+int icachestat(struct icachestat*);
+int nice(int, int);
+int nsleep(uint64);
+int faultaround(int);
+int pfstat(struct pfstat*);
+void* mmap(void*, uint64, int, int, int, int);
+int munmap(void*, uint64);
+int traceread(struct traceev*, int);
+int syslat(uint64*);
+int profile(int);
+int profread(struct profsample*, int);
+int lockstat(struct lockstat*, int);
 
-void* shm_open(void);
-int shm_close(void);
+void* shm_open(char*, uint64, void*);
+int shm_close(void*);
 
 // ulib.c
 int stat(const char*, struct stat*);
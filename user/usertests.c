@@ -7,6 +7,8 @@
 #include "kernel/syscall.h"
 #include "kernel/memlayout.h"
 #include "kernel/riscv.h"
+#include "kernel/trace.h"
+#include "kernel/prof.h"
 
 //
 // Tests xv6 system calls.  usertests without arguments runs them all
@@ -582,6 +584,9 @@ void
 writebig(char *s)
 {
   int i, fd, n;
+  // past the indirect blocks, but leaving room for the
+  // programs on the disk; MAXFILE is far bigger than FSSIZE.
+  int nblocks = MAXFILE < FSSIZE/4 ? MAXFILE : FSSIZE/4;
 
   fd = open("big", O_CREATE|O_RDWR);
   if(fd < 0){
@@ -589,7 +594,7 @@ writebig(char *s)
     exit(1);
   }
 
-  for(i = 0; i < MAXFILE; i++){
+  for(i = 0; i < nblocks; i++){
     ((int*)buf)[0] = i;
     if(write(fd, buf, BSIZE) != BSIZE){
       printf("%s: error: write big file failed i=%d\n", s, i);
@@ -609,7 +614,7 @@ writebig(char *s)
   for(;;){
     i = read(fd, buf, BSIZE);
     if(i == 0){
-      if(n != MAXFILE){
+      if(n != nblocks){
         printf("%s: read only %d blocks from big", s, n);
         exit(1);
       }
@@ -2748,6 +2753,705 @@ lazy_sbrk(char *s)
   exit(0);
 }
 
+// copy-on-write fork: stores by the child, from user code
+// and via copyout() in read(), must not be visible to the
+// parent, and vice versa.
+void
+cowfork(char *s)
+{
+  enum { N = 16 };
+  int fds[2], i, xstatus;
+  char *p = sbrk(N*PGSIZE);
+
+  if(p == SBRK_ERROR){
+    printf("%s: sbrk failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < N; i++)
+    p[i*PGSIZE] = 'p';
+
+  if(pipe(fds) != 0){
+    printf("%s: pipe() failed\n", s);
+    exit(1);
+  }
+  int pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    for(i = 0; i < N; i++){
+      if(p[i*PGSIZE] != 'p'){
+        printf("%s: child sees wrong data\n", s);
+        exit(1);
+      }
+      p[i*PGSIZE] = 'c';
+    }
+    // kernel store into a shared page.
+    if(read(fds[0], p + PGSIZE + 1, 1) != 1 || p[PGSIZE + 1] != 'k'){
+      printf("%s: read into cow page failed\n", s);
+      exit(1);
+    }
+    exit(0);
+  }
+  p[0] = 'P';
+  if(write(fds[1], "k", 1) != 1){
+    printf("%s: pipe write failed\n", s);
+    exit(1);
+  }
+  wait(&xstatus);
+  if(xstatus != 0)
+    exit(xstatus);
+  close(fds[0]);
+  close(fds[1]);
+  for(i = 1; i < N; i++){
+    if(p[i*PGSIZE] != 'p' || (i == 1 && p[PGSIZE + 1] == 'k')){
+      printf("%s: parent sees child's stores\n", s);
+      exit(1);
+    }
+  }
+  if(p[0] != 'P'){
+    printf("%s: parent lost its own store\n", s);
+    exit(1);
+  }
+  exit(0);
+}
+
+// fsync() while other processes keep the log busy.
+void
+fsynctest(char *s)
+{
+  enum { NCHILD = 3, N = 20, SZ = 1000 };
+  char name[8];
+  int fd, i, j, xstatus;
+
+  if(fsync(-1) != -1 || fsync(100) != -1){
+    printf("%s: fsync of a bad fd succeeded\n", s);
+    exit(1);
+  }
+  for(i = 0; i < NCHILD; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf("%s: fork failed\n", s);
+      exit(1);
+    }
+    if(pid == 0){
+      name[0] = 'y';
+      name[1] = '0' + i;
+      name[2] = '\0';
+      fd = open(name, O_CREATE | O_RDWR | O_TRUNC);
+      if(fd < 0){
+        printf("%s: create %s failed\n", s, name);
+        exit(1);
+      }
+      memset(buf, '0' + i, SZ);
+      for(j = 0; j < N; j++){
+        if(write(fd, buf, SZ) != SZ){
+          printf("%s: write failed\n", s);
+          exit(1);
+        }
+        if(j % 4 == 0 && fsync(fd) != 0){
+          printf("%s: fsync failed\n", s);
+          exit(1);
+        }
+      }
+      close(fd);
+      exit(0);
+    }
+  }
+  for(i = 0; i < NCHILD; i++){
+    wait(&xstatus);
+    if(xstatus != 0)
+      exit(xstatus);
+  }
+  for(i = 0; i < NCHILD; i++){
+    name[0] = 'y';
+    name[1] = '0' + i;
+    name[2] = '\0';
+    fd = open(name, O_RDONLY);
+    if(fd < 0){
+      printf("%s: open %s failed\n", s, name);
+      exit(1);
+    }
+    for(j = 0; j < N; j++){
+      if(read(fd, buf, SZ) != SZ || buf[0] != '0' + i || buf[SZ-1] != '0' + i){
+        printf("%s: wrong data in %s\n", s, name);
+        exit(1);
+      }
+    }
+    close(fd);
+    unlink(name);
+  }
+}
+
+// a lazy page fault maps the pages around the faulting one,
+// and faultaround(1) goes back to one page per fault.
+void
+faultaroundtest(char *s)
+{
+  struct pfstat st0, st1;
+  char *a;
+  int i, n = 64;
+
+  if(faultaround(-1) != FAULTAROUND){
+    printf("%s: default cluster is not %d\n", s, FAULTAROUND);
+    exit(1);
+  }
+  pfstat(&st0);
+  a = sbrk(n * PGSIZE);
+  for(i = 0; i < n; i++){
+    if(a[i * PGSIZE + 7] != 0){
+      printf("%s: page %d not zero\n", s, i);
+      exit(1);
+    }
+    a[i * PGSIZE] = i;
+  }
+  pfstat(&st1);
+  if(st1.faults - st0.faults >= n / 2 || st1.pages - st0.pages < n){
+    printf("%s: %d faults mapped %d pages\n", s,
+           (int)(st1.faults - st0.faults), (int)(st1.pages - st0.pages));
+    exit(1);
+  }
+
+  if(faultaround(1) != FAULTAROUND){
+    printf("%s: faultaround(1) failed\n", s);
+    exit(1);
+  }
+  a = sbrk(n * PGSIZE);
+  for(i = 0; i < n; i++)
+    a[i * PGSIZE] = i;
+  pfstat(&st0);
+  if(st0.faults - st1.faults != n){
+    printf("%s: %d faults for %d pages\n", s, (int)(st0.faults - st1.faults), n);
+    exit(1);
+  }
+  faultaround(FAULTAROUND);
+}
+
+// a fault in a megapage-aligned block of fresh heap maps the
+// whole block at once; fork() and shrinking the heap into the
+// middle of it still work page by page.
+void
+megapagetest(char *s)
+{
+  struct pfstat st0, st1;
+  char *a, *cur;
+  int i, pid, xstatus;
+
+  cur = sbrk(0);
+  if(sbrk(MEGASIZE - (uint64)cur % MEGASIZE) == (char*)-1){
+    printf("%s: sbrk failed\n", s);
+    exit(1);
+  }
+  a = sbrk(MEGASIZE);
+  if(a == (char*)-1 || (uint64)a % MEGASIZE != 0){
+    printf("%s: sbrk failed\n", s);
+    exit(1);
+  }
+  pfstat(&st0);
+  for(i = 0; i < MEGASIZE; i += PGSIZE)
+    a[i] = i / PGSIZE;
+  pfstat(&st1);
+  if(st1.faults - st0.faults != 1 || st1.pages - st0.pages != MEGASIZE / PGSIZE){
+    printf("%s: %d faults for a megapage\n", s, (int)(st1.faults - st0.faults));
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    for(i = 0; i < MEGASIZE; i += PGSIZE){
+      if(a[i] != (char)(i / PGSIZE)){
+        printf("%s: child sees wrong data\n", s);
+        exit(1);
+      }
+      a[i] = 0;
+    }
+    exit(0);
+  }
+  wait(&xstatus);
+  if(xstatus != 0)
+    exit(xstatus);
+
+  if(sbrk(-(MEGASIZE / 2)) == (char*)-1){
+    printf("%s: shrink failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < MEGASIZE / 2; i += PGSIZE){
+    if(a[i] != (char)(i / PGSIZE)){
+      printf("%s: parent sees wrong data at %d\n", s, i);
+      exit(1);
+    }
+  }
+}
+
+// mmap() of a file, private and shared, of anonymous memory,
+// and across fork(); munmap() writes shared pages back.
+void
+mmaptest(char *s)
+{
+  enum { SZ = 2*PGSIZE + 100 };
+  char *a, *b;
+  int fd, i, pid, xstatus;
+
+  unlink("mmapfile");
+  fd = open("mmapfile", O_CREATE | O_RDWR);
+  if(fd < 0){
+    printf("%s: create failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < SZ; i++)
+    buf[i] = 'a' + i % 26;
+  if(write(fd, buf, SZ) != SZ){
+    printf("%s: write failed\n", s);
+    exit(1);
+  }
+
+  // private: reads the file, stores stay in memory.
+  a = mmap(0, SZ, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if(a == (char*)-1){
+    printf("%s: mmap private failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < SZ; i++){
+    if(a[i] != 'a' + i % 26){
+      printf("%s: private byte %d is %d\n", s, i, a[i]);
+      exit(1);
+    }
+  }
+  if(a[SZ] != 0){
+    printf("%s: page past end of file not zero\n", s);
+    exit(1);
+  }
+  a[0] = 'X';
+
+  // shared: stores reach the file on munmap(), and a
+  // child's stores are seen by the parent.
+  b = mmap(0, SZ, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(b == (char*)-1 || b == a){
+    printf("%s: mmap shared failed\n", s);
+    exit(1);
+  }
+  if(b[0] != 'a'){
+    printf("%s: private store reached the shared mapping\n", s);
+    exit(1);
+  }
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    b[1] = 'Y';
+    a[1] = 'Z';
+    exit(0);
+  }
+  wait(&xstatus);
+  if(xstatus != 0)
+    exit(xstatus);
+  if(b[1] != 'Y' || a[1] != 'b'){
+    printf("%s: fork sharing wrong\n", s);
+    exit(1);
+  }
+  if(munmap(a, SZ) != 0 || munmap(b, SZ) != 0){
+    printf("%s: munmap failed\n", s);
+    exit(1);
+  }
+  close(fd);
+
+  fd = open("mmapfile", O_RDONLY);
+  if(read(fd, buf, 3) != 3 || buf[0] != 'a' || buf[1] != 'Y' || buf[2] != 'c'){
+    printf("%s: shared stores not written back\n", s);
+    exit(1);
+  }
+  // a read-only descriptor can't back a writable shared mapping.
+  if(mmap(0, PGSIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) != (char*)-1){
+    printf("%s: writable shared mmap of O_RDONLY file\n", s);
+    exit(1);
+  }
+  close(fd);
+  unlink("mmapfile");
+
+  // anonymous: zeroed, and a hole can be punched in the middle.
+  a = mmap(0, 3*PGSIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(a == (char*)-1 || a[0] != 0 || a[3*PGSIZE-1] != 0){
+    printf("%s: anonymous mmap failed\n", s);
+    exit(1);
+  }
+  a[0] = a[2*PGSIZE] = 1;
+  if(munmap(a + PGSIZE, PGSIZE) != 0 || a[0] != 1 || a[2*PGSIZE] != 1){
+    printf("%s: munmap of a hole failed\n", s);
+    exit(1);
+  }
+  if(munmap(a, 3*PGSIZE) != 0){
+    printf("%s: munmap failed\n", s);
+    exit(1);
+  }
+}
+
+// write() and read() of a file mapping that hasn't been touched
+// yet, through a pipe, whose lock is held while copying.
+void
+mmappipetest(char *s)
+{
+  enum { SZ = 2*PGSIZE, N = 512 };
+  char *a;
+  int fd, fds[2], i;
+
+  unlink("mmapfile");
+  fd = open("mmapfile", O_CREATE | O_RDWR);
+  if(fd < 0){
+    printf("%s: create failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < SZ; i++)
+    buf[i] = 'a' + i % 26;
+  if(write(fd, buf, SZ) != SZ){
+    printf("%s: write failed\n", s);
+    exit(1);
+  }
+  a = mmap(0, SZ, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if(a == (char*)-1){
+    printf("%s: mmap failed\n", s);
+    exit(1);
+  }
+  close(fd);
+  unlink("mmapfile");
+  // map one page per fault, so the second page stays untouched.
+  faultaround(1);
+
+  if(pipe(fds) != 0){
+    printf("%s: pipe failed\n", s);
+    exit(1);
+  }
+  if(write(fds[1], a, N) != N){
+    printf("%s: write from mapping failed\n", s);
+    exit(1);
+  }
+  if(read(fds[0], a + PGSIZE, N) != N){
+    printf("%s: read into mapping failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < N; i++){
+    if(a[PGSIZE + i] != 'a' + i % 26){
+      printf("%s: byte %d is %d\n", s, i, a[PGSIZE + i]);
+      exit(1);
+    }
+  }
+  close(fds[0]);
+  close(fds[1]);
+  munmap(a, SZ);
+}
+
+// a shared file mapping that fork() copies before either process
+// touches it, and a second mapping of the same file, all see one
+// copy of each page, which reaches the file.
+void
+mmapsharetest(char *s)
+{
+  enum { SZ = 2*PGSIZE };
+  char *a, *b;
+  int fd, i, pid, xstatus;
+
+  unlink("mmapfile");
+  fd = open("mmapfile", O_CREATE | O_RDWR);
+  if(fd < 0){
+    printf("%s: create failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < SZ; i++)
+    buf[i] = 'a' + i % 26;
+  if(write(fd, buf, SZ) != SZ){
+    printf("%s: write failed\n", s);
+    exit(1);
+  }
+  a = mmap(0, SZ, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(a == (char*)-1){
+    printf("%s: mmap failed\n", s);
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    a[0] = 'C';
+    a[PGSIZE] = 'C';
+    exit(0);
+  }
+  a[1] = 'P';
+  wait(&xstatus);
+  if(xstatus != 0)
+    exit(xstatus);
+  if(a[0] != 'C' || a[PGSIZE] != 'C'){
+    printf("%s: parent doesn't see the child's stores\n", s);
+    exit(1);
+  }
+
+  b = mmap(0, SZ, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if(b == (char*)-1 || b == a){
+    printf("%s: second mmap failed\n", s);
+    exit(1);
+  }
+  b[2] = 'Q';
+  if(b[0] != 'C' || b[1] != 'P' || a[2] != 'Q'){
+    printf("%s: mappings of one file differ\n", s);
+    exit(1);
+  }
+  if(munmap(a, SZ) != 0 || munmap(b, SZ) != 0){
+    printf("%s: munmap failed\n", s);
+    exit(1);
+  }
+  close(fd);
+
+  fd = open("mmapfile", O_RDONLY);
+  if(read(fd, buf, SZ) != SZ || buf[0] != 'C' || buf[1] != 'P' ||
+     buf[2] != 'Q' || buf[3] != 'd' || buf[PGSIZE] != 'C'){
+    printf("%s: file doesn't hold every store\n", s);
+    exit(1);
+  }
+  close(fd);
+  unlink("mmapfile");
+}
+
+// a named shared memory segment is inherited by fork(), can be
+// attached again by name, and goes away with its last attachment.
+void
+shmtest(char *s)
+{
+  char *want = (char*)(TRAPFRAME - 64*PGSIZE);
+  char *a, *b;
+  int pid, xstatus;
+
+  a = shm_open("ushm", 3*PGSIZE, want);
+  if(a != want){
+    printf("%s: shm_open at %p returned %p\n", s, want, a);
+    exit(1);
+  }
+  if(a[0] != 0 || a[3*PGSIZE-1] != 0){
+    printf("%s: new segment not zero\n", s);
+    exit(1);
+  }
+  a[0] = 'x';
+  if(shm_open("ushm", 4*PGSIZE, 0) != (char*)-1){
+    printf("%s: attached more than the segment holds\n", s);
+    exit(1);
+  }
+  if(shm_open("ushm", 0, a) != (char*)-1){
+    printf("%s: attached over an existing region\n", s);
+    exit(1);
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    a[2*PGSIZE + 5] = 'c';
+    b = shm_open("ushm", 0, 0);
+    if(b == (char*)-1 || b == a || b[2*PGSIZE + 5] != 'c' || b[0] != 'x'){
+      printf("%s: second attachment wrong\n", s);
+      exit(1);
+    }
+    shm_close(a);
+    exit(0);
+  }
+  wait(&xstatus);
+  if(xstatus != 0)
+    exit(xstatus);
+  if(a[2*PGSIZE + 5] != 'c'){
+    printf("%s: child's store not shared\n", s);
+    exit(1);
+  }
+
+  if(shm_close(a + PGSIZE) != -1 || shm_close(a) != 0){
+    printf("%s: shm_close failed\n", s);
+    exit(1);
+  }
+  a = shm_open("ushm", PGSIZE, 0);
+  if(a == (char*)-1 || a[0] != 0){
+    printf("%s: segment outlived its last attachment\n", s);
+    exit(1);
+  }
+  shm_close(a);
+}
+
+// nsleep() and pause() wake up on time, also while
+// another process is asleep with a later deadline.
+void
+nsleeptest(char *s)
+{
+  int i, t0, t, pid, xstatus;
+
+  if(nsleep(0) != 0){
+    printf("%s: nsleep(0) failed\n", s);
+    exit(1);
+  }
+  pid = fork();
+  if(pid < 0){
+    printf("%s: fork failed\n", s);
+    exit(1);
+  }
+  if(pid == 0){
+    pause(1000);
+    exit(0);
+  }
+  t0 = uptime();
+  for(i = 0; i < 10; i++){
+    if(nsleep(50 * 1000 * 1000) != 0){
+      printf("%s: nsleep failed\n", s);
+      exit(1);
+    }
+  }
+  t = uptime() - t0;
+  // 10 x 50ms is about 5 ticks.
+  if(t < 4 || t > 15){
+    printf("%s: 10 x 50ms took %d ticks\n", s, t);
+    exit(1);
+  }
+  kill(pid);
+  wait(&xstatus);
+}
+
+// traced system calls come back from traceread() with their
+// arguments and results, and untraced ones don't.
+void
+tracetest(char *s)
+{
+  struct traceev ev[8];
+  int i, n, seen = 0, pid = getpid();
+
+  while(traceread(ev, 8) > 0)
+    ;
+  trace(1L << SYS_getpid);
+  for(i = 0; i < 3; i++)
+    getpid();
+  uptime();
+  trace(0);
+  while((n = traceread(ev, 8)) > 0){
+    for(i = 0; i < n; i++){
+      if(ev[i].pid != pid)
+        continue;
+      if(ev[i].num != SYS_getpid || ev[i].ret != pid || ev[i].exit < ev[i].enter){
+        printf("%s: bad event for syscall %d\n", s, ev[i].num);
+        exit(1);
+      }
+      seen++;
+    }
+  }
+  if(n < 0 || seen != 3){
+    printf("%s: %d getpid events, expected 3\n", s, seen);
+    exit(1);
+  }
+}
+
+// every system call lands in the latency histograms.
+void
+syslattest(char *s)
+{
+  static uint64 h0[NLATSYS][NLATBUCKET], h1[NLATSYS][NLATBUCKET];
+  uint64 n = 0;
+  int i;
+
+  if(syslat(&h0[0][0]) < 0){
+    printf("%s: syslat failed\n", s);
+    exit(1);
+  }
+  for(i = 0; i < 100; i++)
+    getpid();
+  syslat(&h1[0][0]);
+  for(i = 0; i < NLATBUCKET; i++)
+    n += h1[SYS_getpid][i] - h0[SYS_getpid][i];
+  if(n < 100){
+    printf("%s: %d getpid calls counted, expected 100\n", s, (int)n);
+    exit(1);
+  }
+  if(syslat((uint64*)0xffffffffffffff00L) != -1){
+    printf("%s: syslat with a bad address succeeded\n", s);
+    exit(1);
+  }
+}
+
+// with the profiler on, a process spinning in user space
+// shows up in the samples, at user addresses.
+void
+proftest(char *s)
+{
+  struct profsample buf[32];
+  int i, n, t0, mine = 0, pid = getpid();
+
+  while(profread(buf, 32) > 0)
+    ;
+  if(profile(PROFMIN - 1) != -1){
+    printf("%s: profile() took too short an interval\n", s);
+    exit(1);
+  }
+  if(profile(500) != 0){
+    printf("%s: profiler was already on\n", s);
+    exit(1);
+  }
+  t0 = uptime();
+  while(uptime() - t0 < 3)
+    ;
+  if(profile(0) != 500){
+    printf("%s: profile() lost the interval\n", s);
+    exit(1);
+  }
+  while((n = profread(buf, 32)) > 0)
+    for(i = 0; i < n; i++)
+      if(buf[i].pc && buf[i].pid == pid && buf[i].user)
+        mine++;
+  if(n < 0 || mine == 0){
+    printf("%s: no samples of this process\n", s);
+    exit(1);
+  }
+}
+
+// locks are counted by name, sleep locks included.
+void
+lockstattest(char *s)
+{
+  static struct lockstat st0[NLOCKSTAT], st1[NLOCKSTAT];
+  int i, n0, n1, fd, proc = -1, inode = -1;
+
+  n0 = lockstat(st0, NLOCKSTAT);
+  if((fd = open("README", 0)) < 0){
+    printf("%s: open README failed\n", s);
+    exit(1);
+  }
+  close(fd);
+  n1 = lockstat(st1, NLOCKSTAT);
+  if(n0 <= 0 || n1 < n0){
+    printf("%s: lockstat returned %d then %d\n", s, n0, n1);
+    exit(1);
+  }
+  for(i = 0; i < n0; i++){
+    if(strcmp(st0[i].name, "proc") == 0 && !st0[i].sleep)
+      proc = i;
+    if(strcmp(st0[i].name, "inode") == 0 && st0[i].sleep)
+      inode = i;
+  }
+  if(proc < 0 || inode < 0){
+    printf("%s: no proc or inode locks\n", s);
+    exit(1);
+  }
+  if(st1[inode].acquires <= st0[inode].acquires ||
+     st1[proc].acquires < st0[proc].acquires){
+    printf("%s: open() didn't lock an inode\n", s);
+    exit(1);
+  }
+  if(lockstat(st1, 1) != 1){
+    printf("%s: lockstat ignored n\n", s);
+    exit(1);
+  }
+}
+
 struct test {
   void (*f)(char *);
   char *s;
@@ -2816,6 +3520,19 @@ struct test {
   {lazy_unmap, "lazy_unmap"},
   {lazy_copy, "lazy_copy"},
   {lazy_sbrk, "lazy_sbrk"},
+  {cowfork, "cowfork"},
+  {fsynctest, "fsync"},
+  {nsleeptest, "nsleep"},
+  {tracetest, "trace"},
+  {syslattest, "syslat"},
+  {proftest, "prof"},
+  {lockstattest, "lockstat"},
+  {faultaroundtest, "faultaround"},
+  {megapagetest, "megapage"},
+  {mmaptest, "mmap"},
+  {mmappipetest, "mmappipe"},
+  {mmapsharetest, "mmapshare"},
+  {shmtest, "shm"},
   { 0, 0},
 };
 
@@ -3016,7 +3733,8 @@ diskfull(char *s)
       done = 1;
       break;
     }
-    for(int i = 0; i < MAXFILE; i++){
+    // no file can be bigger than the disk.
+    for(int i = 0; i < FSSIZE; i++){
       char buf[BSIZE];
       if(write(fd, buf, BSIZE) != BSIZE){
         done = 1;
@@ -50,3 +50,18 @@ entry("map_ro");
 entry("mapzero");
 entry("shm_open");
 entry("shm_close");
+entry("spawn");
+entry("splice");
+entry("fsync");
+entry("icachestat");
+entry("nice");
+entry("nsleep");
+entry("faultaround");
+entry("pfstat");
+entry("mmap");
+entry("munmap");
+entry("traceread");
+entry("syslat");
+entry("profile");
+entry("profread");
+entry("lockstat");